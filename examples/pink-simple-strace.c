@@ -264,8 +264,46 @@ decode_socketcall(struct process *proc, const char *scname)
 	printf(", %u)", sockaddr.length);
 }
 
+/* Handlers called at system call entry through the dispatch table. */
+static int
+dispatch_open(pid_t pid, struct pink_regset *regs, long scno, void *data)
+{
+	decode_open(data);
+	return 0;
+}
+
+static int
+dispatch_execve(pid_t pid, struct pink_regset *regs, long scno, void *data)
+{
+	decode_execve(data);
+	return 0;
+}
+
+static int
+dispatch_socketcall(pid_t pid, struct pink_regset *regs, long scno, void *data)
+{
+	struct process *proc = data;
+
+	decode_socketcall(proc, pink_name_syscall(scno, proc->abi));
+	return 0;
+}
+
 static void
-handle_syscall(struct process *proc)
+dispatch_setup(struct pink_dispatch *dispatch, struct process *proc)
+{
+	/*
+	 * Register the decoders for every ABI at once, dispatching a system
+	 * call is then a table lookup by number.
+	 */
+	pink_dispatch_register_name(dispatch, "open", dispatch_open, NULL, proc);
+	pink_dispatch_register_name(dispatch, "execve", dispatch_execve, NULL, proc);
+	pink_dispatch_register_name(dispatch, "socketcall", dispatch_socketcall, NULL, proc);
+	pink_dispatch_register_name(dispatch, "bind", dispatch_socketcall, NULL, proc);
+	pink_dispatch_register_name(dispatch, "connect", dispatch_socketcall, NULL, proc);
+}
+
+static void
+handle_syscall(struct process *proc, struct pink_dispatch *dispatch)
 {
 	int r;
 	long scno;
@@ -291,17 +329,13 @@ handle_syscall(struct process *proc)
 			perror("pink_read_syscall");
 			return;
 		}
-		scname = pink_name_syscall(scno, proc->abi);
-		if (!scname)
-			printf("%ld()", scno);
-		else if (!strcmp(scname, "open"))
-			decode_open(proc);
-		else if (!strcmp(scname, "execve"))
-			decode_execve(proc);
-		else if (!strcmp(scname, "socketcall") || !strcmp(scname, "bind") || !strcmp(scname, "connect"))
-			decode_socketcall(proc, scname);
-		else
+		if (pink_dispatch_lookup(dispatch, proc->abi, scno))
+			pink_dispatch_call(dispatch, proc->pid, proc->regs,
+					   proc->abi, scno, false);
+		else if ((scname = pink_name_syscall(scno, proc->abi)))
 			printf("%s()", scname);
+		else
+			printf("%ld()", scno);
 	}
 }
 
@@ -311,6 +345,7 @@ main(int argc, char **argv)
 	int r, sig, status, exit_code;
 	enum pink_event event;
 	struct process proc;
+	struct pink_dispatch *dispatch;
 
 	/* Parse arguments */
 	if (argc < 2) {
@@ -324,6 +359,12 @@ main(int argc, char **argv)
 		perror("pink_regset_alloc");
 		return EXIT_FAILURE;
 	}
+	if ((r = pink_dispatch_alloc(&dispatch)) < 0) {
+		errno = -r;
+		perror("pink_dispatch_alloc");
+		return EXIT_FAILURE;
+	}
+	dispatch_setup(dispatch, &proc);
 
 	/* Fork */
 	if ((proc.pid = fork()) < 0) {
@@ -398,7 +439,7 @@ main(int argc, char **argv)
 			switch (event) {
 			case 0:
 				process_update(&proc);
-				handle_syscall(&proc);
+				handle_syscall(&proc, dispatch);
 				break;
 			case PINK_EVENT_EXEC:
 				/* Update abi */
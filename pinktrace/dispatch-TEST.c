@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2021 Ali Polatel <alip@exherbo.org>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "pinktrace-check.h"
+
+#include <signal.h>
+
+static void dispatch_alloc_or_fail(struct pink_dispatch **dispatch)
+{
+	int r;
+
+	if ((r = pink_dispatch_alloc(dispatch)) < 0)
+		fail_verbose("pink_dispatch_alloc (errno:%d %s)", -r, strerror(-r));
+}
+
+static int dispatch_count(pid_t pid, struct pink_regset *regset,
+			  long sysnum, void *data)
+{
+	unsigned *count = data;
+
+	(*count)++;
+	return 1;
+}
+
+/*
+ * Test whether handlers are found by number:
+ * Register handlers by name and check they are found for the system call
+ * number of every ABI, and only at the right direction.
+ */
+static void test_dispatch_register(void)
+{
+	short abi;
+	long sysnum;
+	unsigned count = 0, expected = 0;
+	struct pink_dispatch *dispatch;
+
+	dispatch_alloc_or_fail(&dispatch);
+
+	if (pink_dispatch_register_name(dispatch, "exit_group",
+					dispatch_count, NULL, &count) < 0)
+		fail_verbose("pink_dispatch_register_name(exit_group) failed");
+	if (pink_dispatch_register_name(dispatch, "pink_floyd",
+					dispatch_count, NULL, &count) != -ENOENT)
+		fail_verbose("pink_dispatch_register_name registered unknown name");
+	if (pink_dispatch_register(dispatch, PINK_ABI_DEFAULT, -1,
+				   dispatch_count, NULL, NULL) != -EINVAL)
+		fail_verbose("pink_dispatch_register registered invalid number");
+
+	for (abi = 0; abi < PINK_ABIS_SUPPORTED; abi++) {
+		sysnum = pink_lookup_syscall("exit_group", abi);
+		if (!pink_dispatch_lookup(dispatch, abi, sysnum))
+			fail_verbose("no handler for exit_group (abi:%d)", abi);
+		if (pink_dispatch_call(dispatch, 0, NULL, abi, sysnum, false) != 1 ||
+		    pink_dispatch_call(dispatch, 0, NULL, abi, sysnum, true) != 0)
+			fail_verbose("wrong handler for exit_group (abi:%d)", abi);
+		expected++;
+		if (pink_dispatch_lookup(dispatch, abi,
+					 pink_lookup_syscall("close", abi)))
+			fail_verbose("handler for close (abi:%d)", abi);
+	}
+	if (count != expected)
+		fail_verbose("handler called %u times, expected %u", count, expected);
+
+	pink_dispatch_register(dispatch, PINK_ABI_DEFAULT,
+			       pink_lookup_syscall("exit_group", PINK_ABI_DEFAULT),
+			       NULL, NULL, NULL);
+	if (pink_dispatch_lookup(dispatch, PINK_ABI_DEFAULT,
+				 pink_lookup_syscall("exit_group", PINK_ABI_DEFAULT)))
+		fail_verbose("handler not unregistered");
+
+	pink_dispatch_free(dispatch);
+}
+
+/*
+ * Test whether a traced system call is dispatched:
+ * Fork a child calling getpid, dispatch each system call stop and check the
+ * entry and exit handlers of getpid are called once.
+ */
+static void test_dispatch_trace(void)
+{
+	pid_t pid;
+	bool exiting = false;
+	unsigned count = 0;
+	long sys_getpid, sysnum;
+	struct pink_dispatch *dispatch;
+	struct pink_regset *regset;
+
+	sys_getpid = pink_lookup_syscall("getpid", PINK_ABI_DEFAULT);
+	dispatch_alloc_or_fail(&dispatch);
+	pink_dispatch_register(dispatch, PINK_ABI_DEFAULT, sys_getpid,
+			       dispatch_count, dispatch_count, &count);
+
+	pid = fork_assert();
+	if (pid == 0) {
+		trace_me_and_stop();
+		syscall(sys_getpid); /* glibc may cache getpid() */
+		_exit(0);
+	}
+	regset_alloc_or_kill(pid, &regset);
+
+	LOOP_WHILE_TRUE() {
+		int status;
+
+		waitpid_no_intr(pid, &status, 0);
+		if (check_exit_code_or_fail(status, 0))
+			break;
+		check_signal_or_fail(status, 0);
+		check_stopped_or_kill(pid, status);
+		if (WSTOPSIG(status) == SIGSTOP) {
+			trace_setup_or_kill(pid, PINK_TRACE_OPTION_SYSGOOD);
+		} else if (WSTOPSIG(status) == (SIGTRAP|0x80)) {
+			regset_fill_or_kill(pid, regset);
+			read_syscall_or_kill(pid, regset, &sysnum);
+			pink_dispatch_call(dispatch, pid, regset, regset->abi,
+					   sysnum, exiting);
+			exiting = !exiting;
+		}
+		trace_syscall_or_kill(pid, 0);
+	}
+
+	info("\tgetpid handler called %u times\n", count);
+	if (count != 2)
+		fail_verbose("getpid handler called %u times, expected 2", count);
+
+	pink_regset_free(regset);
+	pink_dispatch_free(dispatch);
+}
+
+static void test_fixture_dispatch(void) {
+	test_fixture_start();
+
+	run_test(test_dispatch_register);
+	run_test(test_dispatch_trace);
+
+	test_fixture_end();
+}
+
+void test_suite_dispatch(void) {
+	test_fixture_dispatch();
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2021 Ali Polatel <alip@exherbo.org>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include <pinktrace/private.h>
+#include <pinktrace/pink.h>
+
+struct pink_dispatch {
+	size_t count[PINK_ABIS_SUPPORTED];
+	struct pink_dispatch_entry *entries[PINK_ABIS_SUPPORTED];
+};
+
+int pink_dispatch_alloc(struct pink_dispatch **dispatchptr)
+{
+	short abi;
+	struct pink_dispatch *dispatch;
+
+	dispatch = calloc(1, sizeof(struct pink_dispatch));
+	if (!dispatch)
+		return -errno;
+
+	/* One entry per row of the system call table of each ABI. */
+	for (abi = 0; abi < PINK_ABIS_SUPPORTED; abi++) {
+		syscall_table(abi, &dispatch->count[abi]);
+		dispatch->entries[abi] = calloc(dispatch->count[abi],
+						sizeof(struct pink_dispatch_entry));
+		if (!dispatch->entries[abi]) {
+			int save_errno = errno;
+			pink_dispatch_free(dispatch);
+			return -save_errno;
+		}
+	}
+
+	*dispatchptr = dispatch;
+	return 0;
+}
+
+void pink_dispatch_free(struct pink_dispatch *dispatch)
+{
+	short abi;
+
+	if (!dispatch)
+		return;
+	for (abi = 0; abi < PINK_ABIS_SUPPORTED; abi++)
+		free(dispatch->entries[abi]);
+	free(dispatch);
+}
+
+int pink_dispatch_register(struct pink_dispatch *dispatch,
+			   short abi, long sysnum,
+			   pink_dispatch_func_t enter,
+			   pink_dispatch_func_t exit,
+			   void *data)
+{
+	long index;
+	struct pink_dispatch_entry *entry;
+
+	if (abi < 0 || abi >= PINK_ABIS_SUPPORTED)
+		return -EINVAL;
+	index = syscall_index(sysnum);
+	if (index < 0 || (size_t)index >= dispatch->count[abi])
+		return -EINVAL;
+
+	entry = &dispatch->entries[abi][index];
+	entry->enter = enter;
+	entry->exit = exit;
+	entry->data = data;
+	return 0;
+}
+
+int pink_dispatch_register_name(struct pink_dispatch *dispatch,
+				const char *name,
+				pink_dispatch_func_t enter,
+				pink_dispatch_func_t exit,
+				void *data)
+{
+	short abi;
+	long sysnum;
+	int r = -ENOENT;
+
+	for (abi = 0; abi < PINK_ABIS_SUPPORTED; abi++) {
+		if ((sysnum = pink_lookup_syscall(name, abi)) < 0)
+			continue;
+		pink_dispatch_register(dispatch, abi, sysnum, enter, exit, data);
+		r = 0;
+	}
+	return r;
+}
+
+const struct pink_dispatch_entry *pink_dispatch_lookup(const struct pink_dispatch *dispatch,
+						       short abi, long sysnum)
+{
+	long index;
+	const struct pink_dispatch_entry *entry;
+
+	if (abi < 0 || abi >= PINK_ABIS_SUPPORTED)
+		return NULL;
+	index = syscall_index(sysnum);
+	if (index < 0 || (size_t)index >= dispatch->count[abi])
+		return NULL;
+
+	entry = &dispatch->entries[abi][index];
+	if (!entry->enter && !entry->exit)
+		return NULL;
+	return entry;
+}
+
+int pink_dispatch_call(const struct pink_dispatch *dispatch,
+		       pid_t pid, struct pink_regset *regset,
+		       short abi, long sysnum, bool exiting)
+{
+	pink_dispatch_func_t func;
+	const struct pink_dispatch_entry *entry;
+
+	if (!(entry = pink_dispatch_lookup(dispatch, abi, sysnum)))
+		return 0;
+	func = exiting ? entry->exit : entry->enter;
+	if (!func)
+		return 0;
+	return func(pid, regset, sysnum, entry->data);
+}
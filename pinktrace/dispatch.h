@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2021 Ali Polatel <alip@exherbo.org>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#ifndef PINK_DISPATCH_H
+#define PINK_DISPATCH_H
+
+/**
+ * @file pinktrace/dispatch.h
+ * @brief Pink's system call dispatch tables
+ *
+ * Do not include this file directly. Use pinktrace/pink.h instead.
+ *
+ * A dispatch table holds a handler entry for every system call of every
+ * supported ABI, indexed directly by the system call number after the same
+ * normalisation pink_name_syscall() does, so dispatching a stop is a single
+ * indexed load rather than a comparison of system call names.
+ *
+ * @defgroup pink_dispatch Pink's system call dispatch tables
+ * @ingroup pinktrace
+ * @{
+ **/
+
+#include <stdbool.h>
+#include <sys/types.h>
+
+/**
+ * This opaque structure represents a dispatch table.
+ **/
+struct pink_dispatch;
+
+/**
+ * System call handler
+ *
+ * @param pid Process ID of the stopped tracee
+ * @param regset Registry set as passed to pink_dispatch_call()
+ * @param sysnum System call number
+ * @param data User data as passed to pink_dispatch_register()
+ * @return Returned by pink_dispatch_call() as is
+ **/
+typedef int (*pink_dispatch_func_t)(pid_t pid, struct pink_regset *regset,
+				    long sysnum, void *data);
+
+/** Structure which represents the handlers of a system call */
+struct pink_dispatch_entry {
+	/** Handler called at system call entry, may be @e NULL **/
+	pink_dispatch_func_t enter;
+
+	/** Handler called at system call exit, may be @e NULL **/
+	pink_dispatch_func_t exit;
+
+	/** User data passed to the handlers **/
+	void *data;
+};
+
+/**
+ * Allocate a dispatch table with no handlers
+ *
+ * @param dispatchptr Pointer to store the dynamically allocated table,
+ *                    Use pink_dispatch_free() to free after use.
+ * @return 0 on success, negated errno on failure
+ **/
+int pink_dispatch_alloc(struct pink_dispatch **dispatchptr)
+	PINK_GCC_ATTR((nonnull(1)));
+
+/**
+ * Free the memory allocated for the dispatch table
+ *
+ * @param dispatch Dispatch table
+ **/
+void pink_dispatch_free(struct pink_dispatch *dispatch);
+
+/**
+ * Register the handlers of a system call
+ *
+ * @note Passing @e NULL for both handlers unregisters the system call.
+ *
+ * @param dispatch Dispatch table
+ * @param abi System call ABI
+ * @param sysnum System call number
+ * @param enter Handler called at system call entry, may be @e NULL
+ * @param exit Handler called at system call exit, may be @e NULL
+ * @param data User data passed to the handlers
+ * @return 0 on success, -EINVAL if the system call is unknown
+ **/
+int pink_dispatch_register(struct pink_dispatch *dispatch,
+			   short abi, long sysnum,
+			   pink_dispatch_func_t enter,
+			   pink_dispatch_func_t exit,
+			   void *data)
+	PINK_GCC_ATTR((nonnull(1)));
+
+/**
+ * Register the handlers of a system call for every ABI which has it
+ *
+ * @param dispatch Dispatch table
+ * @param name Name of the system call
+ * @param enter Handler called at system call entry, may be @e NULL
+ * @param exit Handler called at system call exit, may be @e NULL
+ * @param data User data passed to the handlers
+ * @return 0 on success, -ENOENT if no ABI has the system call
+ **/
+int pink_dispatch_register_name(struct pink_dispatch *dispatch,
+				const char *name,
+				pink_dispatch_func_t enter,
+				pink_dispatch_func_t exit,
+				void *data)
+	PINK_GCC_ATTR((nonnull(1,2)));
+
+/**
+ * Look up the handlers of a system call
+ *
+ * @param dispatch Dispatch table
+ * @param abi System call ABI
+ * @param sysnum System call number
+ * @return Pointer to the entry, @e NULL if no handlers are registered
+ **/
+const struct pink_dispatch_entry *pink_dispatch_lookup(const struct pink_dispatch *dispatch,
+						       short abi, long sysnum)
+	PINK_GCC_ATTR((nonnull(1)));
+
+/**
+ * Call the handler of a system call
+ *
+ * @param dispatch Dispatch table
+ * @param pid Process ID of the stopped tracee
+ * @param regset Registry set, passed to the handler as is
+ * @param abi System call ABI
+ * @param sysnum System call number
+ * @param exiting True at system call exit, false at system call entry
+ * @return Return value of the handler, 0 if no handler is registered
+ **/
+int pink_dispatch_call(const struct pink_dispatch *dispatch,
+		       pid_t pid, struct pink_regset *regset,
+		       short abi, long sysnum, bool exiting)
+	PINK_GCC_ATTR((nonnull(1)));
+
+/** @} */
+#endif
@@ -1,2 +0,0 @@
-/* arm personality */
-#include "../signalent.h"
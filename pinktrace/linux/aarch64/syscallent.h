@@ -243,22 +243,22 @@
 	"accept4", /* 242 */
 	"recvmmsg", /* 243 */
 /* [244 ... 259] are arch specific */
-	NULL, /* 244 */
-	NULL, /* 245 */
-	NULL, /* 246 */
-	NULL, /* 247 */
-	NULL, /* 248 */
-	NULL, /* 249 */
-	NULL, /* 250 */
-	NULL, /* 251 */
-	NULL, /* 252 */
-	NULL, /* 253 */
-	NULL, /* 254 */
-	NULL, /* 255 */
-	NULL, /* 256 */
-	NULL, /* 257 */
-	NULL, /* 258 */
-	NULL, /* 259 */
+	"", /* 244 */
+	"", /* 245 */
+	"", /* 246 */
+	"", /* 247 */
+	"", /* 248 */
+	"", /* 249 */
+	"", /* 250 */
+	"", /* 251 */
+	"", /* 252 */
+	"", /* 253 */
+	"", /* 254 */
+	"", /* 255 */
+	"", /* 256 */
+	"", /* 257 */
+	"", /* 258 */
+	"", /* 259 */
 	"wait4", /* 260 */
 	"prlimit64", /* 261 */
 	"fanotify_init", /* 262 */
@@ -295,135 +295,135 @@
 	"rseq", /* 293 */
 	"kexec_file_load", /* 294 */
 /* [295 ... 423] - reserved to sync up with other architectures */
-	NULL, /* 295 */
-	NULL, /* 296 */
-	NULL, /* 297 */
-	NULL, /* 298 */
-	NULL, /* 299 */
-	NULL, /* 300 */
-	NULL, /* 301 */
-	NULL, /* 302 */
-	NULL, /* 303 */
-	NULL, /* 304 */
-	NULL, /* 305 */
-	NULL, /* 306 */
-	NULL, /* 307 */
-	NULL, /* 308 */
-	NULL, /* 309 */
-	NULL, /* 310 */
-	NULL, /* 311 */
-	NULL, /* 312 */
-	NULL, /* 313 */
-	NULL, /* 314 */
-	NULL, /* 315 */
-	NULL, /* 316 */
-	NULL, /* 317 */
-	NULL, /* 318 */
-	NULL, /* 319 */
-	NULL, /* 320 */
-	NULL, /* 321 */
-	NULL, /* 322 */
-	NULL, /* 323 */
-	NULL, /* 324 */
-	NULL, /* 325 */
-	NULL, /* 326 */
-	NULL, /* 327 */
-	NULL, /* 328 */
-	NULL, /* 329 */
-	NULL, /* 330 */
-	NULL, /* 331 */
-	NULL, /* 332 */
-	NULL, /* 333 */
-	NULL, /* 334 */
-	NULL, /* 335 */
-	NULL, /* 336 */
-	NULL, /* 337 */
-	NULL, /* 338 */
-	NULL, /* 339 */
-	NULL, /* 340 */
-	NULL, /* 341 */
-	NULL, /* 342 */
-	NULL, /* 343 */
-	NULL, /* 344 */
-	NULL, /* 345 */
-	NULL, /* 346 */
-	NULL, /* 347 */
-	NULL, /* 348 */
-	NULL, /* 349 */
-	NULL, /* 350 */
-	NULL, /* 351 */
-	NULL, /* 352 */
-	NULL, /* 353 */
-	NULL, /* 354 */
-	NULL, /* 355 */
-	NULL, /* 356 */
-	NULL, /* 357 */
-	NULL, /* 358 */
-	NULL, /* 359 */
-	NULL, /* 360 */
-	NULL, /* 361 */
-	NULL, /* 362 */
-	NULL, /* 363 */
-	NULL, /* 364 */
-	NULL, /* 365 */
-	NULL, /* 366 */
-	NULL, /* 367 */
-	NULL, /* 368 */
-	NULL, /* 369 */
-	NULL, /* 370 */
-	NULL, /* 371 */
-	NULL, /* 372 */
-	NULL, /* 373 */
-	NULL, /* 374 */
-	NULL, /* 375 */
-	NULL, /* 376 */
-	NULL, /* 377 */
-	NULL, /* 378 */
-	NULL, /* 379 */
-	NULL, /* 380 */
-	NULL, /* 381 */
-	NULL, /* 382 */
-	NULL, /* 383 */
-	NULL, /* 384 */
-	NULL, /* 385 */
-	NULL, /* 386 */
-	NULL, /* 387 */
-	NULL, /* 388 */
-	NULL, /* 389 */
-	NULL, /* 390 */
-	NULL, /* 391 */
-	NULL, /* 392 */
-	NULL, /* 393 */
-	NULL, /* 394 */
-	NULL, /* 395 */
-	NULL, /* 396 */
-	NULL, /* 397 */
-	NULL, /* 398 */
-	NULL, /* 399 */
-	NULL, /* 400 */
-	NULL, /* 401 */
-	NULL, /* 402 */
-	NULL, /* 403 */
-	NULL, /* 404 */
-	NULL, /* 405 */
-	NULL, /* 406 */
-	NULL, /* 407 */
-	NULL, /* 408 */
-	NULL, /* 409 */
-	NULL, /* 410 */
-	NULL, /* 411 */
-	NULL, /* 412 */
-	NULL, /* 413 */
-	NULL, /* 414 */
-	NULL, /* 415 */
-	NULL, /* 416 */
-	NULL, /* 417 */
-	NULL, /* 418 */
-	NULL, /* 419 */
-	NULL, /* 420 */
-	NULL, /* 421 */
-	NULL, /* 422 */
-	NULL, /* 423 */
+	"", /* 295 */
+	"", /* 296 */
+	"", /* 297 */
+	"", /* 298 */
+	"", /* 299 */
+	"", /* 300 */
+	"", /* 301 */
+	"", /* 302 */
+	"", /* 303 */
+	"", /* 304 */
+	"", /* 305 */
+	"", /* 306 */
+	"", /* 307 */
+	"", /* 308 */
+	"", /* 309 */
+	"", /* 310 */
+	"", /* 311 */
+	"", /* 312 */
+	"", /* 313 */
+	"", /* 314 */
+	"", /* 315 */
+	"", /* 316 */
+	"", /* 317 */
+	"", /* 318 */
+	"", /* 319 */
+	"", /* 320 */
+	"", /* 321 */
+	"", /* 322 */
+	"", /* 323 */
+	"", /* 324 */
+	"", /* 325 */
+	"", /* 326 */
+	"", /* 327 */
+	"", /* 328 */
+	"", /* 329 */
+	"", /* 330 */
+	"", /* 331 */
+	"", /* 332 */
+	"", /* 333 */
+	"", /* 334 */
+	"", /* 335 */
+	"", /* 336 */
+	"", /* 337 */
+	"", /* 338 */
+	"", /* 339 */
+	"", /* 340 */
+	"", /* 341 */
+	"", /* 342 */
+	"", /* 343 */
+	"", /* 344 */
+	"", /* 345 */
+	"", /* 346 */
+	"", /* 347 */
+	"", /* 348 */
+	"", /* 349 */
+	"", /* 350 */
+	"", /* 351 */
+	"", /* 352 */
+	"", /* 353 */
+	"", /* 354 */
+	"", /* 355 */
+	"", /* 356 */
+	"", /* 357 */
+	"", /* 358 */
+	"", /* 359 */
+	"", /* 360 */
+	"", /* 361 */
+	"", /* 362 */
+	"", /* 363 */
+	"", /* 364 */
+	"", /* 365 */
+	"", /* 366 */
+	"", /* 367 */
+	"", /* 368 */
+	"", /* 369 */
+	"", /* 370 */
+	"", /* 371 */
+	"", /* 372 */
+	"", /* 373 */
+	"", /* 374 */
+	"", /* 375 */
+	"", /* 376 */
+	"", /* 377 */
+	"", /* 378 */
+	"", /* 379 */
+	"", /* 380 */
+	"", /* 381 */
+	"", /* 382 */
+	"", /* 383 */
+	"", /* 384 */
+	"", /* 385 */
+	"", /* 386 */
+	"", /* 387 */
+	"", /* 388 */
+	"", /* 389 */
+	"", /* 390 */
+	"", /* 391 */
+	"", /* 392 */
+	"", /* 393 */
+	"", /* 394 */
+	"", /* 395 */
+	"", /* 396 */
+	"", /* 397 */
+	"", /* 398 */
+	"", /* 399 */
+	"", /* 400 */
+	"", /* 401 */
+	"", /* 402 */
+	"", /* 403 */
+	"", /* 404 */
+	"", /* 405 */
+	"", /* 406 */
+	"", /* 407 */
+	"", /* 408 */
+	"", /* 409 */
+	"", /* 410 */
+	"", /* 411 */
+	"", /* 412 */
+	"", /* 413 */
+	"", /* 414 */
+	"", /* 415 */
+	"", /* 416 */
+	"", /* 417 */
+	"", /* 418 */
+	"", /* 419 */
+	"", /* 420 */
+	"", /* 421 */
+	"", /* 422 */
+	"", /* 423 */
 	"pidfd_send_signal", /* 424 */
 	"io_uring_setup", /* 425 */
 	"io_uring_enter", /* 426 */
@@ -398,7 +398,7 @@
 	/* ARM specific syscalls. Encoded with scno 0x000f00xx.
 	 * Remapped by shuffle_scno() to be directly after __ARM_NR_cmpxchg.
 	 */
-        NULL, /* 0 */
+        "", /* 0 */
 	"breakpoint", /* 1 */
 	"cacheflush", /* 2 */
 	"usr26", /* 3 */
@@ -278,10 +278,10 @@
 	"sync_file_range", /* 1300 */
 	"tee", /* 1301 */
 	"vmsplice", /* 1302 */
-	NULL, /* 1303 */
+	"", /* 1303 */
 	"getcpu", /* 1304 */
 	"epoll_pwait", /* 1305 */
-	NULL, /* 1306 */
+	"", /* 1306 */
 	"signalfd", /* 1307 */
 	"timerfd", /* 1308 */
 	"eventfd", /* 1309 */
@@ -1 +0,0 @@
-#include "../errnoent.h"
@@ -1,2 +0,0 @@
-/* i386 personality */
-#include "../errnoent.h"
@@ -1 +0,0 @@
-#include "../signalent.h"
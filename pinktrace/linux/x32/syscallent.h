@@ -334,95 +334,95 @@
 	"io_pgetevents", /* 333 */
 	"rseq", /* 334 */
 /* [335 ... 423] - reserved to sync up with other architectures */
-	NULL, /* 335 */
-	NULL, /* 336 */
-	NULL, /* 337 */
-	NULL, /* 338 */
-	NULL, /* 339 */
-	NULL, /* 340 */
-	NULL, /* 341 */
-	NULL, /* 342 */
-	NULL, /* 343 */
-	NULL, /* 344 */
-	NULL, /* 345 */
-	NULL, /* 346 */
-	NULL, /* 347 */
-	NULL, /* 348 */
-	NULL, /* 349 */
-	NULL, /* 350 */
-	NULL, /* 351 */
-	NULL, /* 352 */
-	NULL, /* 353 */
-	NULL, /* 354 */
-	NULL, /* 355 */
-	NULL, /* 356 */
-	NULL, /* 357 */
-	NULL, /* 358 */
-	NULL, /* 359 */
-	NULL, /* 360 */
-	NULL, /* 361 */
-	NULL, /* 362 */
-	NULL, /* 363 */
-	NULL, /* 364 */
-	NULL, /* 365 */
-	NULL, /* 366 */
-	NULL, /* 367 */
-	NULL, /* 368 */
-	NULL, /* 369 */
-	NULL, /* 370 */
-	NULL, /* 371 */
-	NULL, /* 372 */
-	NULL, /* 373 */
-	NULL, /* 374 */
-	NULL, /* 375 */
-	NULL, /* 376 */
-	NULL, /* 377 */
-	NULL, /* 378 */
-	NULL, /* 379 */
-	NULL, /* 380 */
-	NULL, /* 381 */
-	NULL, /* 382 */
-	NULL, /* 383 */
-	NULL, /* 384 */
-	NULL, /* 385 */
-	NULL, /* 386 */
-	NULL, /* 387 */
-	NULL, /* 388 */
-	NULL, /* 389 */
-	NULL, /* 390 */
-	NULL, /* 391 */
-	NULL, /* 392 */
-	NULL, /* 393 */
-	NULL, /* 394 */
-	NULL, /* 395 */
-	NULL, /* 396 */
-	NULL, /* 397 */
-	NULL, /* 398 */
-	NULL, /* 399 */
-	NULL, /* 400 */
-	NULL, /* 401 */
-	NULL, /* 402 */
-	NULL, /* 403 */
-	NULL, /* 404 */
-	NULL, /* 405 */
-	NULL, /* 406 */
-	NULL, /* 407 */
-	NULL, /* 408 */
-	NULL, /* 409 */
-	NULL, /* 410 */
-	NULL, /* 411 */
-	NULL, /* 412 */
-	NULL, /* 413 */
-	NULL, /* 414 */
-	NULL, /* 415 */
-	NULL, /* 416 */
-	NULL, /* 417 */
-	NULL, /* 418 */
-	NULL, /* 419 */
-	NULL, /* 420 */
-	NULL, /* 421 */
-	NULL, /* 422 */
-	NULL, /* 423 */
+	"", /* 335 */
+	"", /* 336 */
+	"", /* 337 */
+	"", /* 338 */
+	"", /* 339 */
+	"", /* 340 */
+	"", /* 341 */
+	"", /* 342 */
+	"", /* 343 */
+	"", /* 344 */
+	"", /* 345 */
+	"", /* 346 */
+	"", /* 347 */
+	"", /* 348 */
+	"", /* 349 */
+	"", /* 350 */
+	"", /* 351 */
+	"", /* 352 */
+	"", /* 353 */
+	"", /* 354 */
+	"", /* 355 */
+	"", /* 356 */
+	"", /* 357 */
+	"", /* 358 */
+	"", /* 359 */
+	"", /* 360 */
+	"", /* 361 */
+	"", /* 362 */
+	"", /* 363 */
+	"", /* 364 */
+	"", /* 365 */
+	"", /* 366 */
+	"", /* 367 */
+	"", /* 368 */
+	"", /* 369 */
+	"", /* 370 */
+	"", /* 371 */
+	"", /* 372 */
+	"", /* 373 */
+	"", /* 374 */
+	"", /* 375 */
+	"", /* 376 */
+	"", /* 377 */
+	"", /* 378 */
+	"", /* 379 */
+	"", /* 380 */
+	"", /* 381 */
+	"", /* 382 */
+	"", /* 383 */
+	"", /* 384 */
+	"", /* 385 */
+	"", /* 386 */
+	"", /* 387 */
+	"", /* 388 */
+	"", /* 389 */
+	"", /* 390 */
+	"", /* 391 */
+	"", /* 392 */
+	"", /* 393 */
+	"", /* 394 */
+	"", /* 395 */
+	"", /* 396 */
+	"", /* 397 */
+	"", /* 398 */
+	"", /* 399 */
+	"", /* 400 */
+	"", /* 401 */
+	"", /* 402 */
+	"", /* 403 */
+	"", /* 404 */
+	"", /* 405 */
+	"", /* 406 */
+	"", /* 407 */
+	"", /* 408 */
+	"", /* 409 */
+	"", /* 410 */
+	"", /* 411 */
+	"", /* 412 */
+	"", /* 413 */
+	"", /* 414 */
+	"", /* 415 */
+	"", /* 416 */
+	"", /* 417 */
+	"", /* 418 */
+	"", /* 419 */
+	"", /* 420 */
+	"", /* 421 */
+	"", /* 422 */
+	"", /* 423 */
 	"pidfd_send_signal", /* 424 */
 	"io_uring_setup", /* 425 */
 	"io_uring_enter", /* 426 */
@@ -441,76 +441,76 @@
 	"faccessat2", /* 439 */
 	"process_madvise", /* 440 */
 	"epoll_pwait2", /* 441 */
-	NULL, /* 442 */
-	NULL, /* 443 */
-	NULL, /* 444 */
-	NULL, /* 445 */
-	NULL, /* 446 */
-	NULL, /* 447 */
-	NULL, /* 448 */
-	NULL, /* 449 */
-	NULL, /* 450 */
-	NULL, /* 451 */
-	NULL, /* 452 */
-	NULL, /* 453 */
-	NULL, /* 454 */
-	NULL, /* 455 */
-	NULL, /* 456 */
-	NULL, /* 457 */
-	NULL, /* 458 */
-	NULL, /* 459 */
-	NULL, /* 460 */
-	NULL, /* 461 */
-	NULL, /* 462 */
-	NULL, /* 463 */
-	NULL, /* 464 */
-	NULL, /* 465 */
-	NULL, /* 466 */
-	NULL, /* 467 */
-	NULL, /* 468 */
-	NULL, /* 469 */
-	NULL, /* 470 */
-	NULL, /* 471 */
-	NULL, /* 472 */
-	NULL, /* 473 */
-	NULL, /* 474 */
-	NULL, /* 475 */
-	NULL, /* 476 */
-	NULL, /* 477 */
-	NULL, /* 478 */
-	NULL, /* 479 */
-	NULL, /* 480 */
-	NULL, /* 481 */
-	NULL, /* 482 */
-	NULL, /* 483 */
-	NULL, /* 484 */
-	NULL, /* 485 */
-	NULL, /* 486 */
-	NULL, /* 487 */
-	NULL, /* 488 */
-	NULL, /* 489 */
-	NULL, /* 490 */
-	NULL, /* 491 */
-	NULL, /* 492 */
-	NULL, /* 493 */
-	NULL, /* 494 */
-	NULL, /* 495 */
-	NULL, /* 496 */
-	NULL, /* 497 */
-	NULL, /* 498 */
-	NULL, /* 499 */
-	NULL, /* 500 */
-	NULL, /* 501 */
-	NULL, /* 502 */
-	NULL, /* 503 */
-	NULL, /* 504 */
-	NULL, /* 505 */
-	NULL, /* 506 */
-	NULL, /* 507 */
-	NULL, /* 508 */
-	NULL, /* 509 */
-	NULL, /* 510 */
-	NULL, /* 511 */
+	"", /* 442 */
+	"", /* 443 */
+	"", /* 444 */
+	"", /* 445 */
+	"", /* 446 */
+	"", /* 447 */
+	"", /* 448 */
+	"", /* 449 */
+	"", /* 450 */
+	"", /* 451 */
+	"", /* 452 */
+	"", /* 453 */
+	"", /* 454 */
+	"", /* 455 */
+	"", /* 456 */
+	"", /* 457 */
+	"", /* 458 */
+	"", /* 459 */
+	"", /* 460 */
+	"", /* 461 */
+	"", /* 462 */
+	"", /* 463 */
+	"", /* 464 */
+	"", /* 465 */
+	"", /* 466 */
+	"", /* 467 */
+	"", /* 468 */
+	"", /* 469 */
+	"", /* 470 */
+	"", /* 471 */
+	"", /* 472 */
+	"", /* 473 */
+	"", /* 474 */
+	"", /* 475 */
+	"", /* 476 */
+	"", /* 477 */
+	"", /* 478 */
+	"", /* 479 */
+	"", /* 480 */
+	"", /* 481 */
+	"", /* 482 */
+	"", /* 483 */
+	"", /* 484 */
+	"", /* 485 */
+	"", /* 486 */
+	"", /* 487 */
+	"", /* 488 */
+	"", /* 489 */
+	"", /* 490 */
+	"", /* 491 */
+	"", /* 492 */
+	"", /* 493 */
+	"", /* 494 */
+	"", /* 495 */
+	"", /* 496 */
+	"", /* 497 */
+	"", /* 498 */
+	"", /* 499 */
+	"", /* 500 */
+	"", /* 501 */
+	"", /* 502 */
+	"", /* 503 */
+	"", /* 504 */
+	"", /* 505 */
+	"", /* 506 */
+	"", /* 507 */
+	"", /* 508 */
+	"", /* 509 */
+	"", /* 510 */
+	"", /* 511 */
 /*
  * x32-specific system call numbers start at 512 to avoid cache impact
  * for native 64-bit operation.
@@ -1,2 +0,0 @@
-/* x32 personality */
-#include "../errnoent.h"
@@ -1,2 +0,0 @@
-/* x32 personality */
-#include "../signalent.h"
@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2021 Ali Polatel <alip@exherbo.org>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "pinktrace-check.h"
+
+#define NAME_MAX_SCNO	1024
+
+/*
+ * Test whether syscall names round trip:
+ * For every system call of every supported ABI, look up the number of its
+ * name and check it maps back to the same name.
+ */
+static void test_name_syscall(void)
+{
+	short abi;
+	long scno, lookup;
+	unsigned count = 0;
+	const char *name;
+
+	for (abi = 0; abi < PINK_ABIS_SUPPORTED; abi++) {
+		for (scno = 0; scno < NAME_MAX_SCNO; scno++) {
+			if (!(name = pink_name_syscall(scno, abi)))
+				continue;
+			lookup = pink_lookup_syscall(name, abi);
+			if (lookup < 0 || lookup > scno ||
+			    strcmp(pink_name_syscall(lookup, abi), name))
+				fail_verbose("pink_lookup_syscall(%s, %d) = %ld, expected %ld",
+					     name, abi, lookup, scno);
+			count++;
+		}
+		if (pink_lookup_syscall("pink_floyd", abi) != -1)
+			fail_verbose("pink_lookup_syscall found unknown system call");
+	}
+	info("\tchecked %u system call names\n", count);
+	if (count == 0)
+		fail_verbose("no system call names");
+}
+
+/*
+ * Test whether errno and signal names round trip:
+ * For every errno and signal of every supported ABI, look up the number of
+ * its name and check it maps back to the same name.
+ */
+static void test_name_errno_signal(void)
+{
+	short abi;
+	int i, lookup;
+	const char *name;
+
+	for (abi = 0; abi < PINK_ABIS_SUPPORTED; abi++) {
+		for (i = 0; (name = pink_name_errno(i, abi)); i++) {
+			lookup = pink_lookup_errno(name, abi);
+			if (lookup < 0 || strcmp(pink_name_errno(lookup, abi), name))
+				fail_verbose("pink_lookup_errno(%s, %d) = %d, expected %d",
+					     name, abi, lookup, i);
+		}
+		for (i = 0; (name = pink_name_signal(i, abi)); i++) {
+			lookup = pink_lookup_signal(name, abi);
+			if (lookup < 0 || strcmp(pink_name_signal(lookup, abi), name))
+				fail_verbose("pink_lookup_signal(%s, %d) = %d, expected %d",
+					     name, abi, lookup, i);
+		}
+	}
+	if (pink_lookup_errno("EPERM", PINK_ABI_DEFAULT) != EPERM)
+		fail_verbose("pink_lookup_errno(EPERM) != %d", EPERM);
+	if (pink_lookup_signal("SIGKILL", PINK_ABI_DEFAULT) != SIGKILL)
+		fail_verbose("pink_lookup_signal(SIGKILL) != %d", SIGKILL);
+	if (pink_lookup_errno("", PINK_ABI_DEFAULT) != -1 ||
+	    pink_lookup_signal(NULL, PINK_ABI_DEFAULT) != -1)
+		fail_verbose("empty names found");
+}
+
+/*
+ * Test whether event, socket subcall and address family names are found.
+ */
+static void test_name_xlat(void)
+{
+	if (pink_lookup_event("EXEC") != PINK_EVENT_EXEC ||
+	    pink_lookup_event("STOP") != PINK_EVENT_STOP ||
+	    pink_lookup_event("PINK") != -1)
+		fail_verbose("pink_lookup_event failed");
+	if (pink_lookup_socket_subcall("accept4") != PINK_SOCKET_SUBCALL_ACCEPT4 ||
+	    pink_lookup_socket_subcall("bind") != PINK_SOCKET_SUBCALL_BIND)
+		fail_verbose("pink_lookup_socket_subcall failed");
+	if (pink_lookup_socket_family("AF_INET") != AF_INET ||
+	    pink_lookup_socket_family("AF_UNIX") != AF_UNIX ||
+	    pink_lookup_socket_family("AF_PINK") != -1)
+		fail_verbose("pink_lookup_socket_family failed");
+}
+
+/*
+ * Test whether canonical system call identifiers round trip:
+ * For every system call of every supported ABI, check its canonical
+ * identifier has the same name and maps back to a system call of that name.
+ * Check a system call common to all ABIs has the same identifier everywhere.
+ */
+static void test_name_canonical(void)
+{
+	short abi;
+	long count, scno, id, lookup;
+	const char *name, *cname;
+
+	count = pink_canonical_count();
+	info("\t%ld canonical system call identifiers\n", count);
+	if (count <= 0)
+		fail_verbose("pink_canonical_count = %ld", count);
+
+	for (abi = 0; abi < PINK_ABIS_SUPPORTED; abi++) {
+		for (scno = 0; scno < NAME_MAX_SCNO; scno++) {
+			if (!(name = pink_name_syscall(scno, abi)))
+				continue;
+			id = pink_canonical_syscall(scno, abi);
+			if (id < 0 || id >= count)
+				fail_verbose("pink_canonical_syscall(%ld, %d) = %ld",
+					     scno, abi, id);
+			cname = pink_name_canonical(id);
+			if (strncmp(cname, name, strlen(cname)))
+				fail_verbose("canonical name %s of %s (abi:%d)",
+					     cname, name, abi);
+			lookup = pink_canonical_number(id, abi);
+			if (lookup < 0 || strncmp(pink_name_syscall(lookup, abi),
+						  cname, strlen(cname)))
+				fail_verbose("pink_canonical_number(%ld, %d) = %ld, expected %s",
+					     id, abi, lookup, cname);
+		}
+	}
+
+	id = pink_lookup_canonical("exit_group");
+	if (id < 0 || strcmp(pink_name_canonical(id), "exit_group"))
+		fail_verbose("pink_lookup_canonical(exit_group) = %ld", id);
+	for (abi = 0; abi < PINK_ABIS_SUPPORTED; abi++) {
+		scno = pink_lookup_syscall("exit_group", abi);
+		if (pink_canonical_syscall(scno, abi) != id ||
+		    pink_canonical_number(id, abi) != scno)
+			fail_verbose("exit_group (abi:%d scno:%ld) does not map to %ld",
+				     abi, scno, id);
+	}
+	if (pink_lookup_canonical("pink_floyd") != -1 ||
+	    pink_name_canonical(count) != NULL ||
+	    pink_canonical_syscall(-1, PINK_ABI_DEFAULT) != -1)
+		fail_verbose("unknown canonical identifier found");
+}
+
+/*
+ * Test whether system call metadata is found:
+ * Check the argument kinds and classes of a few system calls and check
+ * unknown system calls have no metadata.
+ */
+static void test_name_syscall_info(void)
+{
+	short abi;
+	long scno;
+	unsigned count = 0;
+	const struct pink_syscall_info *sinfo;
+
+	sinfo = pink_syscall_info(pink_lookup_syscall("openat", PINK_ABI_DEFAULT),
+				  PINK_ABI_DEFAULT);
+	if (!sinfo)
+		fail_verbose("no metadata for openat");
+	if (sinfo->nargs != 4 ||
+	    sinfo->args[0] != PINK_ARG_DIRFD ||
+	    sinfo->args[1] != PINK_ARG_PATH ||
+	    sinfo->args[2] != PINK_ARG_FLAGS ||
+	    !(sinfo->classes & PINK_SYSCALL_CLASS_FILE))
+		fail_verbose("wrong metadata for openat");
+
+	sinfo = pink_syscall_info(pink_lookup_syscall("connect", PINK_ABI_DEFAULT),
+				  PINK_ABI_DEFAULT);
+	if (!sinfo || sinfo->args[1] != PINK_ARG_SOCKADDR ||
+	    sinfo->classes != PINK_SYSCALL_CLASS_NETWORK)
+		fail_verbose("wrong metadata for connect");
+
+	if (pink_syscall_info(-1, PINK_ABI_DEFAULT) ||
+	    pink_syscall_info(NAME_MAX_SCNO * 1024, PINK_ABI_DEFAULT) ||
+	    pink_syscall_info(0, PINK_ABIS_SUPPORTED))
+		fail_verbose("metadata for unknown system call");
+
+	for (abi = 0; abi < PINK_ABIS_SUPPORTED; abi++) {
+		for (scno = 0; scno < NAME_MAX_SCNO; scno++) {
+			if (!(sinfo = pink_syscall_info(scno, abi)))
+				continue;
+			if (sinfo->nargs > PINK_MAX_ARGS)
+				fail_verbose("system call %ld of abi %d has %u arguments",
+					     scno, abi, sinfo->nargs);
+			count++;
+		}
+	}
+	info("\tfound metadata for %u system calls\n", count);
+}
+
+static void test_fixture_name(void) {
+	test_fixture_start();
+
+	run_test(test_name_syscall);
+	run_test(test_name_errno_signal);
+	run_test(test_name_xlat);
+	run_test(test_name_canonical);
+	run_test(test_name_syscall_info);
+
+	test_fixture_end();
+}
+
+void test_suite_name(void) {
+	test_fixture_name();
+}
@@ -14,36 +14,33 @@
 #include <pinktrace/private.h>
 #include <pinktrace/pink.h>
 
-const char *const errnoent0[] = {
+/*
+ * Names are stored in fixed size rows rather than as arrays of pointers to
+ * string literals, so the tables need no relocations when the library is
+ * loaded and stay in shared, read-only pages. Empty rows denote unused
+ * system call numbers.
+ *
+ * Personalities share the errno and signal tables of the native ABI, none
+ * of the supported architectures number them differently.
+ */
+const char errnoent0[][ERRNO_NAME_SIZE] = {
 #include "errnoent.h"
 };
-const char *const signalent0[] = {
+const char signalent0[][SIGNAL_NAME_SIZE] = {
 #include "signalent.h"
 };
-const char *const sysent0[] = {
+const char sysent0[][SYSCALL_NAME_SIZE] = {
 #include "syscallent.h"
 };
 
 #if PINK_ABIS_SUPPORTED > 1
-const char *const errnoent1[] = {
-# include "errnoent1.h"
-};
-const char *const signalent1[] = {
-# include "signalent1.h"
-};
-const char *const sysent1[] = {
+const char sysent1[][SYSCALL_NAME_SIZE] = {
 # include "syscallent1.h"
 };
 #endif
 
 #if PINK_ABIS_SUPPORTED > 2
-const char *const errnoent2[] = {
-# include "errnoent2.h"
-};
-const char *const signalent2[] = {
-# include "signalent2.h"
-};
-const char *const sysent2[] = {
+const char sysent2[][SYSCALL_NAME_SIZE] = {
 #include "syscallent2.h"
 };
 #endif
@@ -52,17 +49,13 @@ const size_t nerrnos0 = ARRAY_SIZE(errnoent0);
 const size_t nsignals0 = ARRAY_SIZE(signalent0);
 const size_t nsyscalls0 = ARRAY_SIZE(sysent0);
 #if PINK_ABIS_SUPPORTED > 1
-const size_t nerrnos1 = ARRAY_SIZE(errnoent1);
-const size_t nsignals1 = ARRAY_SIZE(signalent1);
 const size_t nsyscalls1 = ARRAY_SIZE(sysent1);
 # if PINK_ABIS_SUPPORTED > 2
-const size_t nerrnos2 = ARRAY_SIZE(errnoent2);
-const size_t nsignals2 = ARRAY_SIZE(signalent2);
 const size_t nsyscalls2 = ARRAY_SIZE(sysent2);
 # endif
 #endif
 
-static const char *const *sysent_vec[PINK_ABIS_SUPPORTED] = {
+static const char (*const sysent_vec[PINK_ABIS_SUPPORTED])[SYSCALL_NAME_SIZE] = {
 	sysent0,
 #if PINK_ABIS_SUPPORTED > 1
 	sysent1,
@@ -71,27 +64,9 @@ static const char *const *sysent_vec[PINK_ABIS_SUPPORTED] = {
 	sysent2,
 #endif
 };
-static const char *const *errnoent_vec[PINK_ABIS_SUPPORTED] = {
-	errnoent0,
-#if PINK_ABIS_SUPPORTED > 1
-	errnoent1,
-#endif
-#if PINK_ABIS_SUPPORTED > 2
-	errnoent2,
-#endif
-};
-static const char *const *signalent_vec[PINK_ABIS_SUPPORTED] = {
-	signalent0,
-#if PINK_ABIS_SUPPORTED > 1
-	signalent1,
-#endif
-#if PINK_ABIS_SUPPORTED > 2
-	signalent2,
-#endif
-};
 
 struct xlat {
-	const char *str;
+	char str[XLAT_NAME_SIZE];
 	int val;
 };
 
@@ -104,7 +79,7 @@ static const struct xlat events[] = {
 	{"EXIT",	PINK_EVENT_EXIT},
 	{"SECCOMP",	PINK_EVENT_SECCOMP},
 	{"STOP",	PINK_EVENT_STOP},
-	{NULL,		0},
+	{"",		0},
 };
 
 static const struct xlat socket_subcalls[] = {
@@ -125,7 +100,7 @@ static const struct xlat socket_subcalls[] = {
 	{"sendmsg",		PINK_SOCKET_SUBCALL_SENDMSG},
 	{"recvmsg",		PINK_SOCKET_SUBCALL_RECVMSG},
 	{"accept4",		PINK_SOCKET_SUBCALL_ACCEPT4},
-	{NULL,			0},
+	{"",			0},
 };
 
 static const struct xlat addrfams[] = {
@@ -282,9 +257,106 @@ static const struct xlat addrfams[] = {
 #ifdef AF_XDP
 	{ "AF_XDP",	AF_XDP},
 #endif
-	{ NULL,		0},
+	{ "",		0},
 };
 
+/*
+ * Reverse lookups use an index of the table entries sorted by name which is
+ * built on first use and searched using binary search. Tables have less than
+ * UINT16_MAX entries, so an index entry fits into 16 bits. The first element
+ * of the index holds the number of entries which follow.
+ *
+ * The index is published atomically: threads racing to build it each build
+ * their own copy and all but the first discard theirs. If the allocation
+ * fails, lookups fall back to a linear scan.
+ */
+/* Entry i of a table whose rows are stride bytes apart */
+#define name_at(base, stride, i) \
+	((const char *)(base) + (size_t)(i) * (stride))
+
+static uint16_t *name_index_build(const void *base, size_t stride, size_t n)
+{
+	size_t i, count = 0;
+	uint16_t *sorted;
+
+	sorted = malloc((n + 1) * sizeof(uint16_t));
+	if (!sorted)
+		return NULL;
+
+	/*
+	 * Insertion sort with binary search for the position: tables are small
+	 * and this runs once. Inserting after equal names keeps the order of
+	 * duplicates so lookups return the first entry like a linear scan.
+	 */
+	for (i = 0; i < n; i++) {
+		size_t lo = 0, hi = count;
+		const char *name = name_at(base, stride, i);
+
+		if (*name == '\0')
+			continue;
+		while (lo < hi) {
+			size_t mid = lo + (hi - lo) / 2;
+			if (strcmp(name_at(base, stride, sorted[mid + 1]), name) <= 0)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		memmove(sorted + lo + 2, sorted + lo + 1,
+			(count - lo) * sizeof(uint16_t));
+		sorted[lo + 1] = i;
+		count++;
+	}
+	sorted[0] = count;
+	return sorted;
+}
+
+long name_index_lookup(struct name_index *index, const void *base,
+			      size_t stride, size_t n, const char *name)
+{
+	size_t i, lo, hi;
+	uint16_t *sorted;
+
+	sorted = __atomic_load_n(&index->sorted, __ATOMIC_ACQUIRE);
+	if (!sorted) {
+		uint16_t *expected = NULL;
+
+		sorted = name_index_build(base, stride, n);
+		if (!sorted) {
+			for (i = 0; i < n; i++) {
+				if (!strcmp(name_at(base, stride, i), name))
+					return i;
+			}
+			return -1;
+		}
+		if (!__atomic_compare_exchange_n(&index->sorted, &expected, sorted,
+						 false, __ATOMIC_ACQ_REL,
+						 __ATOMIC_ACQUIRE)) {
+			free(sorted);
+			sorted = expected;
+		}
+	}
+
+	lo = 0;
+	hi = sorted[0];
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if (strcmp(name_at(base, stride, sorted[mid + 1]), name) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo < sorted[0] && !strcmp(name_at(base, stride, sorted[lo + 1]), name))
+		return sorted[lo + 1];
+	return -1;
+}
+
+static struct name_index sysent_index[PINK_ABIS_SUPPORTED];
+static struct name_index errnoent_index;
+static struct name_index signalent_index;
+static struct name_index events_index;
+static struct name_index socket_subcalls_index;
+static struct name_index addrfams_index;
+
 /*
  * Shuffle syscall numbers so that we don't have huge gaps in syscall table.
  * The shuffling should be an involution: shuffle_scno(shuffle_scno(n)) == n.
@@ -322,25 +394,61 @@ shuffle_scno(unsigned long scno)
 # define shuffle_scno(scno) ((long)(scno))
 #endif
 
+long syscall_index(long scno)
+{
+#ifdef SYSCALL_OFFSET
+	scno -= SYSCALL_OFFSET;
+#endif
+	return shuffle_scno(scno);
+}
+
+long syscall_number(long index)
+{
+#ifdef SYSCALL_OFFSET
+	return index + SYSCALL_OFFSET;
+#else
+	return shuffle_scno(index);
+#endif
+}
+
+const char (*syscall_table(short abi, size_t *countptr))[SYSCALL_NAME_SIZE]
+{
+	const size_t nsyscall_vec[PINK_ABIS_SUPPORTED] = {
+		nsyscalls0,
+#if PINK_ABIS_SUPPORTED > 1
+		nsyscalls1,
+#endif
+#if PINK_ABIS_SUPPORTED > 2
+		nsyscalls2,
+#endif
+	};
+
+	if (abi < 0 || abi >= PINK_ABIS_SUPPORTED)
+		return NULL;
+	*countptr = nsyscall_vec[abi];
+	return sysent_vec[abi];
+}
+
 PINK_GCC_ATTR((pure))
 static const char *xname(const struct xlat *xlat, int val)
 {
-	for (; xlat->str != NULL; xlat++)
+	for (; xlat->str[0] != '\0'; xlat++)
 		if (xlat->val == val)
 			return xlat->str;
 	return NULL;
 }
 
-PINK_GCC_ATTR((pure))
-static int xlookup(const struct xlat *xlat, const char *str)
+static int xlookup(struct name_index *index, const struct xlat *xlat,
+		   size_t n, const char *str)
 {
+	long i;
+
 	if (!str || *str == '\0')
 		return -1;
 
-	for (; xlat->str != NULL; xlat++)
-		if (!strcmp(str, xlat->str))
-			return xlat->val;
-	return -1;
+	/* The last entry is the terminating empty entry. */
+	i = name_index_lookup(index, xlat->str, sizeof(struct xlat), n - 1, str);
+	return i < 0 ? -1 : xlat[i].val;
 }
 
 PINK_GCC_ATTR((pure))
@@ -352,7 +460,7 @@ const char *pink_name_event(enum pink_event event)
 PINK_GCC_ATTR((pure))
 int pink_lookup_event(const char *name)
 {
-	return xlookup(events, name);
+	return xlookup(&events_index, events, ARRAY_SIZE(events), name);
 }
 
 PINK_GCC_ATTR((pure))
@@ -364,7 +472,7 @@ const char *pink_name_socket_family(int family)
 PINK_GCC_ATTR((pure))
 int pink_lookup_socket_family(const char *name)
 {
-	return xlookup(addrfams, name);
+	return xlookup(&addrfams_index, addrfams, ARRAY_SIZE(addrfams), name);
 }
 
 PINK_GCC_ATTR((pure))
@@ -376,35 +484,21 @@ const char *pink_name_socket_subcall(enum pink_socket_subcall subcall)
 PINK_GCC_ATTR((pure))
 int pink_lookup_socket_subcall(const char *name)
 {
-	return xlookup(socket_subcalls, name);
+	return xlookup(&socket_subcalls_index, socket_subcalls,
+		       ARRAY_SIZE(socket_subcalls), name);
 }
 
 PINK_GCC_ATTR((pure))
 const char *pink_name_syscall(long scno, short abi)
 {
-	int nsyscalls;
-	const char *const *sysent;
-	const size_t nsyscall_vec[PINK_ABIS_SUPPORTED] = {
-		nsyscalls0,
-#if PINK_ABIS_SUPPORTED > 1
-		nsyscalls1,
-#endif
-#if PINK_ABIS_SUPPORTED > 2
-		nsyscalls2,
-#endif
-	};
+	size_t nsyscalls;
+	const char (*sysent)[SYSCALL_NAME_SIZE];
 
-	if (abi < 0 || abi >= PINK_ABIS_SUPPORTED)
+	if (!(sysent = syscall_table(abi, &nsyscalls)))
 		return NULL;
 
-	nsyscalls = nsyscall_vec[abi];
-	sysent = sysent_vec[abi];
-#ifdef SYSCALL_OFFSET
-	scno -= SYSCALL_OFFSET;
-#endif
-
-	scno = shuffle_scno(scno);
-	if (scno < 0 || scno >= nsyscalls)
+	scno = syscall_index(scno);
+	if (scno < 0 || (size_t)scno >= nsyscalls || sysent[scno][0] == '\0')
 		return NULL;
 	return sysent[scno];
 }
@@ -412,152 +506,260 @@ const char *pink_name_syscall(long scno, short abi)
 PINK_GCC_ATTR((pure))
 long pink_lookup_syscall(const char *name, short abi)
 {
-	int nsyscalls;
-	const char *const *sysent;
-	long scno;
-	const size_t nsyscall_vec[PINK_ABIS_SUPPORTED] = {
-		nsyscalls0,
-#if PINK_ABIS_SUPPORTED > 1
-		nsyscalls1,
-#endif
-#if PINK_ABIS_SUPPORTED > 2
-		nsyscalls2,
-#endif
-	};
+	size_t nsyscalls;
+	const char (*sysent)[SYSCALL_NAME_SIZE];
+	long index;
 
 	if (!name || *name == '\0')
 		return -1;
-	if (abi < 0 || abi >= PINK_ABIS_SUPPORTED)
+	if (!(sysent = syscall_table(abi, &nsyscalls)))
 		return -1;
 
-	nsyscalls = nsyscall_vec[abi];
-	sysent = sysent_vec[abi];
+	index = name_index_lookup(&sysent_index[abi], sysent, SYSCALL_NAME_SIZE,
+				  nsyscalls, name);
+	return index < 0 ? -1 : syscall_number(index);
+}
 
-	for (scno = 0; scno < nsyscalls; scno++) {
-		if (sysent[scno] && !strcmp(sysent[scno], name)) {
-#ifdef SYSCALL_OFFSET
-			return scno + SYSCALL_OFFSET;
-#else
-			return shuffle_scno(scno);
-#endif
+/*
+ * Canonical system call identifiers number the union of the system call
+ * names of all supported ABIs, sorted by name, so a system call has the same
+ * identifier whichever ABI it is called from. The x32 table marks the 64-bit
+ * variants of some system calls with a "#64" suffix, these share the
+ * identifier of the system call without the suffix.
+ *
+ * The translation tables are built from the system call tables on first use
+ * and published atomically like the name indexes above. Table entries hold
+ * an index plus one, zero denotes no mapping.
+ */
+struct canon {
+	size_t count;
+	char (*names)[SYSCALL_NAME_SIZE];
+	uint16_t *ids[PINK_ABIS_SUPPORTED];
+	uint16_t *indexes[PINK_ABIS_SUPPORTED];
+};
+
+static struct canon *canon_tables;
+
+/* Compare system call names ignoring the "#64" suffix */
+static int canon_strcmp(const char *a, const char *b)
+{
+	for (; *a == *b && *a != '\0' && *a != '#'; a++, b++)
+		;
+	if ((*a == '\0' || *a == '#') && (*b == '\0' || *b == '#'))
+		return 0;
+	return (unsigned char)*a - (unsigned char)*b;
+}
+
+static int canon_qsort_cmp(const void *a, const void *b)
+{
+	return canon_strcmp(*(const char *const *)a, *(const char *const *)b);
+}
+
+static long canon_search(const struct canon *canon, const char *name)
+{
+	size_t lo = 0, hi = canon->count;
+
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		int r = canon_strcmp(canon->names[mid], name);
+		if (r == 0)
+			return mid;
+		else if (r < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return -1;
+}
+
+static struct canon *canon_build(void)
+{
+	short abi;
+	size_t i, n, len, count, total = 0;
+	size_t nsyscalls[PINK_ABIS_SUPPORTED];
+	const char (*sysent[PINK_ABIS_SUPPORTED])[SYSCALL_NAME_SIZE];
+	const char **sorted;
+	struct canon *canon;
+	char *p;
+
+	for (abi = 0; abi < PINK_ABIS_SUPPORTED; abi++) {
+		sysent[abi] = syscall_table(abi, &nsyscalls[abi]);
+		total += nsyscalls[abi];
+	}
+
+	sorted = malloc(total * sizeof(const char *));
+	if (!sorted)
+		return NULL;
+	for (n = 0, abi = 0; abi < PINK_ABIS_SUPPORTED; abi++)
+		for (i = 0; i < nsyscalls[abi]; i++)
+			if (sysent[abi][i][0] != '\0')
+				sorted[n++] = sysent[abi][i];
+	qsort(sorted, n, sizeof(const char *), canon_qsort_cmp);
+	for (count = 0, i = 0; i < n; i++)
+		if (count == 0 || canon_strcmp(sorted[count - 1], sorted[i]))
+			sorted[count++] = sorted[i];
+
+	/* The structure and all its tables live in a single allocation. */
+	len = sizeof(struct canon) + count * SYSCALL_NAME_SIZE;
+	for (abi = 0; abi < PINK_ABIS_SUPPORTED; abi++)
+		len += (nsyscalls[abi] + count) * sizeof(uint16_t);
+	if (!(p = calloc(1, len))) {
+		free(sorted);
+		return NULL;
+	}
+	canon = (struct canon *)p;
+	p += sizeof(struct canon);
+	canon->count = count;
+	canon->names = (char (*)[SYSCALL_NAME_SIZE])p;
+	p += count * SYSCALL_NAME_SIZE;
+	for (i = 0; i < count; i++)
+		memcpy(canon->names[i], sorted[i], strcspn(sorted[i], "#"));
+	free(sorted);
+
+	for (abi = 0; abi < PINK_ABIS_SUPPORTED; abi++) {
+		canon->ids[abi] = (uint16_t *)p;
+		p += nsyscalls[abi] * sizeof(uint16_t);
+		canon->indexes[abi] = (uint16_t *)p;
+		p += count * sizeof(uint16_t);
+
+		for (i = 0; i < nsyscalls[abi]; i++) {
+			long id;
+			uint16_t *index;
+
+			if (sysent[abi][i][0] == '\0')
+				continue;
+			id = canon_search(canon, sysent[abi][i]);
+			canon->ids[abi][i] = id + 1;
+
+			/* Prefer the system call over its "#64" variant. */
+			index = &canon->indexes[abi][id];
+			if (*index == 0 || (strchr(sysent[abi][*index - 1], '#') &&
+					    !strchr(sysent[abi][i], '#')))
+				*index = i + 1;
 		}
 	}
 
-	return -1;
+	return canon;
 }
 
-PINK_GCC_ATTR((pure))
-const char *pink_name_errno(int err_no, short abi)
+static const struct canon *canon_get(void)
 {
-	int nerrnos;
-	const char *const *errnoent;
-	const size_t nerrno_vec[PINK_ABIS_SUPPORTED] = {
-		nerrnos0,
-#if PINK_ABIS_SUPPORTED > 1
-		nerrnos1,
-#endif
-#if PINK_ABIS_SUPPORTED > 2
-		nerrnos2,
-#endif
-	};
+	struct canon *canon, *expected = NULL;
+
+	canon = __atomic_load_n(&canon_tables, __ATOMIC_ACQUIRE);
+	if (canon)
+		return canon;
+	if (!(canon = canon_build()))
+		return NULL;
+	if (!__atomic_compare_exchange_n(&canon_tables, &expected, canon,
+					 false, __ATOMIC_ACQ_REL,
+					 __ATOMIC_ACQUIRE)) {
+		free(canon);
+		canon = expected;
+	}
+	return canon;
+}
+
+long pink_canonical_count(void)
+{
+	const struct canon *canon;
+
+	if (!(canon = canon_get()))
+		return -ENOMEM;
+	return canon->count;
+}
+
+long pink_canonical_syscall(long scno, short abi)
+{
+	size_t nsyscalls;
+	const struct canon *canon;
+
+	if (!syscall_table(abi, &nsyscalls))
+		return -1;
+	scno = syscall_index(scno);
+	if (scno < 0 || (size_t)scno >= nsyscalls)
+		return -1;
+	if (!(canon = canon_get()))
+		return -1;
+	return (long)canon->ids[abi][scno] - 1;
+}
+
+long pink_canonical_number(long id, short abi)
+{
+	const struct canon *canon;
 
 	if (abi < 0 || abi >= PINK_ABIS_SUPPORTED)
+		return -1;
+	if (!(canon = canon_get()))
+		return -1;
+	if (id < 0 || (size_t)id >= canon->count ||
+	    canon->indexes[abi][id] == 0)
+		return -1;
+	return syscall_number(canon->indexes[abi][id] - 1);
+}
+
+const char *pink_name_canonical(long id)
+{
+	const struct canon *canon;
+
+	if (!(canon = canon_get()))
+		return NULL;
+	if (id < 0 || (size_t)id >= canon->count)
 		return NULL;
+	return canon->names[id];
+}
 
-	nerrnos = nerrno_vec[abi];
-	errnoent = errnoent_vec[abi];
+long pink_lookup_canonical(const char *name)
+{
+	const struct canon *canon;
+
+	if (!name || *name == '\0')
+		return -1;
+	if (!(canon = canon_get()))
+		return -1;
+	return canon_search(canon, name);
+}
 
-	if (err_no < 0 || err_no >= nerrnos)
+PINK_GCC_ATTR((pure))
+const char *pink_name_errno(int err_no, short abi)
+{
+	if (abi < 0 || abi >= PINK_ABIS_SUPPORTED)
+		return NULL;
+	if (err_no < 0 || (size_t)err_no >= nerrnos0)
 		return NULL;
-	return errnoent[err_no];
+	return errnoent0[err_no];
 }
 
 PINK_GCC_ATTR((pure))
 int pink_lookup_errno(const char *name, short abi)
 {
-	int nerrnos;
-	const char *const *errnoent;
-	int err_no;
-	const size_t nerrno_vec[PINK_ABIS_SUPPORTED] = {
-		nerrnos0,
-#if PINK_ABIS_SUPPORTED > 1
-		nerrnos1,
-#endif
-#if PINK_ABIS_SUPPORTED > 2
-		nerrnos2,
-#endif
-	};
-
 	if (!name || *name == '\0')
 		return -1;
 	if (abi < 0 || abi >= PINK_ABIS_SUPPORTED)
 		return -1;
 
-	nerrnos = nerrno_vec[abi];
-	errnoent = errnoent_vec[abi];
-
-	for (err_no = 0; err_no < nerrnos; err_no++) {
-		if (errnoent[err_no] && !strcmp(errnoent[err_no], name))
-			return err_no;
-	}
-
-	return -1;
+	return name_index_lookup(&errnoent_index, errnoent0, ERRNO_NAME_SIZE,
+				 nerrnos0, name);
 }
 
 PINK_GCC_ATTR((pure))
 const char *pink_name_signal(int sig, short abi)
 {
-	int nsignals;
-	const char *const *signalent;
-	const size_t nsignal_vec[PINK_ABIS_SUPPORTED] = {
-		nsignals0,
-#if PINK_ABIS_SUPPORTED > 1
-		nsignals1,
-#endif
-#if PINK_ABIS_SUPPORTED > 2
-		nsignals2,
-#endif
-	};
-
 	if (abi < 0 || abi >= PINK_ABIS_SUPPORTED)
 		return NULL;
-
-	nsignals = nsignal_vec[abi];
-	signalent = signalent_vec[abi];
-
-	if (sig < 0 || sig >= nsignals)
+	if (sig < 0 || (size_t)sig >= nsignals0)
 		return NULL;
-	return signalent[sig];
+	return signalent0[sig];
 }
 
 PINK_GCC_ATTR((pure))
 int pink_lookup_signal(const char *name, short abi)
 {
-	int nsignals;
-	const char *const *signalent;
-	int sig;
-	const size_t nsignal_vec[PINK_ABIS_SUPPORTED] = {
-		nsignals0,
-#if PINK_ABIS_SUPPORTED > 1
-		nsignals1,
-#endif
-#if PINK_ABIS_SUPPORTED > 2
-		nsignals2,
-#endif
-	};
-
 	if (!name || *name == '\0')
 		return -1;
 	if (abi < 0 || abi >= PINK_ABIS_SUPPORTED)
 		return -1;
 
-	nsignals = nsignal_vec[abi];
-	signalent = signalent_vec[abi];
-
-	for (sig = 0; sig < nsignals; sig++) {
-		if (signalent[sig] && !strcmp(signalent[sig], name))
-			return sig;
-	}
-
-	return -1;
+	return name_index_lookup(&signalent_index, signalent0, SIGNAL_NAME_SIZE,
+				 nsignals0, name);
 }
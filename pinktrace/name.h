@@ -55,6 +55,56 @@ const char *pink_name_syscall(long scno, short abi)
 long pink_lookup_syscall(const char *name, short abi)
 	PINK_GCC_ATTR((pure));
 
+/**
+ * Return the number of canonical system call identifiers.
+ *
+ * Canonical identifiers number the system calls of all supported ABIs
+ * densely from zero, so a system call has the same identifier whichever ABI
+ * it is called from. Use them to index a single dispatch table or policy
+ * bitmap which serves tracees of every ABI.
+ *
+ * @note The translation tables are built on first use.
+ *
+ * @return Number of canonical identifiers on success, negated errno on
+ *         failure
+ **/
+long pink_canonical_count(void);
+
+/**
+ * Translate a system call number to its canonical identifier.
+ *
+ * @param scno System call number
+ * @param abi System call ABI
+ * @return Canonical identifier on success, -1 if the system call is unknown
+ **/
+long pink_canonical_syscall(long scno, short abi);
+
+/**
+ * Translate a canonical identifier to the system call number of an ABI.
+ *
+ * @param id Canonical identifier
+ * @param abi System call ABI
+ * @return System call number on success, -1 if the ABI has no such system
+ *         call
+ **/
+long pink_canonical_number(long id, short abi);
+
+/**
+ * Return the name of the given canonical identifier.
+ *
+ * @param id Canonical identifier
+ * @return The name of the system call, NULL if the identifier is unknown
+ **/
+const char *pink_name_canonical(long id);
+
+/**
+ * Look up the canonical identifier of the given system call name.
+ *
+ * @param name Name of the system call
+ * @return Canonical identifier on successful lookup, -1 otherwise
+ **/
+long pink_lookup_canonical(const char *name);
+
 /**
  * Return the name of the given socket address family.
  *
@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2021 Ali Polatel <alip@exherbo.org>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "pinktrace-check.h"
+
+#include <poll.h>
+#include <signal.h>
+
+static const unsigned int test_options = PINK_TRACE_OPTION_SYSGOOD;
+
+static bool pidfd_open_or_skip(pid_t pid, int *pidfd)
+{
+	int r;
+
+	r = pink_pidfd_open(pid, 0);
+	if (r == -ENOSYS) {
+		message("\tpidfd_open not supported, skipping test\n");
+		kill(pid, SIGKILL);
+		waitpid_no_intr(pid, NULL, __WALL);
+		return false;
+	} else if (r < 0) {
+		kill(pid, SIGKILL);
+		fail_verbose("pink_pidfd_open (pid:%u errno:%d %s)",
+			     pid, -r, strerror(-r));
+		return false;
+	}
+	*pidfd = r;
+	return true;
+}
+
+static void pidfd_wait_or_kill(pid_t pid, int pidfd, int *status, int options)
+{
+	pid_t r;
+
+	r = pink_pidfd_wait(pidfd, status, options);
+	info("\tpidfd_wait(%d, %#x) = %d (status:%#x)\n",
+	     pidfd, (unsigned)options, r, (unsigned)*status);
+	if (r != pid) {
+		kill(pid, SIGKILL);
+		fail_verbose("pink_pidfd_wait (pid:%u pidfd:%d returned:%d errno:%d %s)",
+			     pid, pidfd, r, r < 0 ? -r : 0, r < 0 ? strerror(-r) : "");
+	}
+}
+
+/*
+ * Test whether stops are harvested correctly using a PID file descriptor:
+ * First fork a new child and wait for the initial SIGSTOP using
+ * pink_pidfd_wait(), then resume it with PTRACE_SYSCALL, poll the file
+ * descriptor returned by pink_sigchld_open() and check whether the system
+ * call stop has the SYSGOOD bit set.
+ */
+static void test_pidfd_wait(void)
+{
+	int pidfd, sigfd, status;
+	pid_t pid, pids[4];
+	sigset_t mask, omask;
+	struct pollfd pfd;
+
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGCHLD);
+	sigprocmask(SIG_BLOCK, &mask, &omask);
+
+	pid = fork_assert();
+	if (pid == 0) {
+		sigprocmask(SIG_SETMASK, &omask, NULL);
+		trace_me_and_stop();
+		syscall(PINK_SYSCALL_INVALID, 0, 0, 0, 0, 0, 0);
+		_exit(0);
+	}
+	if (!pidfd_open_or_skip(pid, &pidfd))
+		goto out;
+	sigfd = pink_sigchld_open();
+	if (sigfd < 0) {
+		kill(pid, SIGKILL);
+		fail_verbose("pink_sigchld_open (errno:%d %s)", -sigfd, strerror(-sigfd));
+		goto out;
+	}
+
+	pidfd_wait_or_kill(pid, pidfd, &status, 0);
+	check_stopped_or_kill(pid, status);
+	if (WSTOPSIG(status) != SIGSTOP) {
+		kill(pid, SIGKILL);
+		fail_verbose("unexpected stop signal %d, expected SIGSTOP", WSTOPSIG(status));
+	}
+	trace_setup_or_kill(pid, test_options);
+	pink_sigchld_read(sigfd, NULL, 0);
+	trace_syscall_or_kill(pid, 0);
+
+	pfd.fd = sigfd;
+	pfd.events = POLLIN;
+	if (poll(&pfd, 1, 10000) != 1) {
+		kill(pid, SIGKILL);
+		fail_verbose("poll on SIGCHLD file descriptor timed out");
+	}
+	if (pink_sigchld_read(sigfd, pids, 4) < 1 || pids[0] != pid) {
+		kill(pid, SIGKILL);
+		fail_verbose("pink_sigchld_read didn't return pid:%u", pid);
+	}
+
+	pidfd_wait_or_kill(pid, pidfd, &status, WNOHANG);
+	check_stopped_or_kill(pid, status);
+	if (WSTOPSIG(status) != (SIGTRAP|0x80) ||
+	    event_decide_and_print(status) != PINK_EVENT_NONE) {
+		kill(pid, SIGKILL);
+		fail_verbose("unexpected stop status %#x, expected syscall stop",
+			     (unsigned)status);
+	}
+
+	kill(pid, SIGKILL);
+	pidfd_wait_or_kill(pid, pidfd, &status, 0);
+	check_signal_or_fail(status, SIGKILL);
+
+	close(sigfd);
+	close(pidfd);
+out:
+	sigprocmask(SIG_SETMASK, &omask, NULL);
+}
+
+/*
+ * Test whether the PID file descriptor reports the termination of the tracee:
+ * First fork a new child, then kill it via the PID file descriptor and poll
+ * the file descriptor for readability.
+ */
+static void test_pidfd_poll_exit(void)
+{
+	int r, pidfd, status;
+	pid_t pid;
+	struct pollfd pfd;
+
+	pid = fork_assert();
+	if (pid == 0) {
+		trace_me_and_stop();
+		_exit(0);
+	}
+	if (!pidfd_open_or_skip(pid, &pidfd))
+		return;
+
+	pidfd_wait_or_kill(pid, pidfd, &status, 0);
+	check_stopped_or_kill(pid, status);
+
+	pfd.fd = pidfd;
+	pfd.events = POLLIN;
+	if (poll(&pfd, 1, 0) != 0) {
+		kill(pid, SIGKILL);
+		fail_verbose("PID file descriptor readable before termination");
+	}
+
+	if ((r = pink_pidfd_send_signal(pidfd, SIGKILL)) < 0) {
+		kill(pid, SIGKILL);
+		fail_verbose("pink_pidfd_send_signal (pid:%u errno:%d %s)",
+			     pid, -r, strerror(-r));
+	}
+	if (poll(&pfd, 1, 10000) != 1)
+		fail_verbose("PID file descriptor not readable after termination");
+
+	pidfd_wait_or_kill(pid, pidfd, &status, 0);
+	check_signal_or_fail(status, SIGKILL);
+	close(pidfd);
+}
+
+static void test_fixture_pidfd(void) {
+	test_fixture_start();
+
+	run_test(test_pidfd_wait);
+	run_test(test_pidfd_poll_exit);
+
+	test_fixture_end();
+}
+
+void test_suite_pidfd(void) {
+	test_fixture_pidfd();
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2021 Ali Polatel <alip@exherbo.org>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include <pinktrace/private.h>
+
+#include <signal.h>
+#ifdef HAVE_SYS_SIGNALFD_H
+#include <sys/signalfd.h>
+#endif
+
+#include <pinktrace/pink.h>
+
+#ifndef P_PIDFD
+# define P_PIDFD 3
+#endif
+
+/*
+ * Translate the result of waitid(2) to a waitpid(2) status.
+ * For stops, si_status holds the whole stop code including the ptrace(2)
+ * event bits so pink_event_decide() keeps working.
+ */
+int siginfo_to_status(const siginfo_t *info, int *status)
+{
+	switch (info->si_code) {
+	case CLD_EXITED:
+		*status = (info->si_status & 0xff) << 8;
+		break;
+	case CLD_KILLED:
+		*status = info->si_status & 0x7f;
+		break;
+	case CLD_DUMPED:
+		*status = (info->si_status & 0x7f) | 0x80;
+		break;
+	case CLD_STOPPED:
+	case CLD_TRAPPED:
+		*status = (info->si_status << 8) | 0x7f;
+		break;
+	case CLD_CONTINUED:
+		*status = 0xffff;
+		break;
+	default:
+		return -EINVAL;
+	}
+	return 0;
+}
+
+int pink_pidfd_open(pid_t pid, unsigned int flags)
+{
+#if PINK_HAVE_PIDFD
+	int fd;
+
+	fd = syscall(SYS_pidfd_open, pid, flags);
+	return fd < 0 ? -errno : fd;
+#else
+	return -ENOSYS;
+#endif
+}
+
+PINK_GCC_ATTR((nonnull(2)))
+pid_t pink_pidfd_wait(int pidfd, int *status, int options)
+{
+#if PINK_HAVE_PIDFD
+	siginfo_t info;
+
+	/*
+	 * Call waitid(2) directly, C libraries don't necessarily know
+	 * about P_PIDFD yet.
+	 */
+	info.si_pid = 0;
+	if (syscall(SYS_waitid, P_PIDFD, pidfd, &info,
+		    options | WEXITED | WSTOPPED | __WALL, NULL) < 0)
+		return -errno;
+	if (info.si_pid == 0) /* WNOHANG */
+		return 0;
+
+	if (siginfo_to_status(&info, status) < 0)
+		return -EINVAL;
+	return info.si_pid;
+#else
+	return -ENOSYS;
+#endif
+}
+
+int pink_pidfd_send_signal(int pidfd, int sig)
+{
+#if PINK_HAVE_PIDFD && defined(SYS_pidfd_send_signal)
+	return syscall(SYS_pidfd_send_signal, pidfd, sig, NULL, 0) < 0 ? -errno : 0;
+#else
+	return -ENOSYS;
+#endif
+}
+
+int pink_sigchld_open(void)
+{
+#ifdef HAVE_SYS_SIGNALFD_H
+	int fd;
+	sigset_t mask;
+
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGCHLD);
+	if (sigprocmask(SIG_BLOCK, &mask, NULL) < 0)
+		return -errno;
+
+	fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+	return fd < 0 ? -errno : fd;
+#else
+	return -ENOSYS;
+#endif
+}
+
+int pink_sigchld_read(int fd, pid_t *pids, size_t count)
+{
+#ifdef HAVE_SYS_SIGNALFD_H
+	int n = 0;
+	struct signalfd_siginfo info[16];
+
+	for (;;) {
+		size_t i;
+		ssize_t r;
+
+		r = read(fd, info, sizeof(info));
+		if (r < 0) {
+			if (errno == EAGAIN)
+				break;
+			if (errno == EINTR)
+				continue;
+			return n > 0 ? n : -errno;
+		}
+		for (i = 0; i < r / sizeof(struct signalfd_siginfo); i++, n++) {
+			if (pids && (size_t)n < count)
+				pids[n] = info[i].ssi_pid;
+		}
+		if ((size_t)r < sizeof(info))
+			break;
+	}
+	return n;
+#else
+	return -ENOSYS;
+#endif
+}
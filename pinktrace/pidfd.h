@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2021 Ali Polatel <alip@exherbo.org>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#ifndef PINK_PIDFD_H
+#define PINK_PIDFD_H
+
+/**
+ * @file pinktrace/pidfd.h
+ * @brief Pink's PID file descriptor helpers for event loops
+ *
+ * Do not include this file directly. Use pinktrace/pink.h instead.
+ *
+ * These functions let a tracer multiplex tracee stops with its own file
+ * descriptors in a single @e epoll(7) based event loop rather than
+ * dedicating a thread blocked in @c waitpid(-1):
+ *
+ * - pink_sigchld_open() returns a file descriptor which becomes readable
+ *   whenever a tracee changes state, ie. stops or terminates.
+ * - pink_pidfd_open() returns a file descriptor referring to a single
+ *   tracee. It becomes readable when the tracee terminates.
+ * - pink_pidfd_wait() harvests the state change of a single tracee without
+ *   scanning all the children of the tracer.
+ *
+ * A typical loop adds the file descriptor returned by pink_sigchld_open() to
+ * the epoll set, calls pink_sigchld_read() on wakeup to learn which tracees
+ * have changed state and calls pink_pidfd_wait() with @c WNOHANG for each.
+ * Note the kernel coalesces pending @c SIGCHLD signals so the tracee list is
+ * merely a hint, tracers must not rely on it to be complete.
+ *
+ * @defgroup pink_pidfd Pink's PID file descriptor helpers for event loops
+ * @ingroup pinktrace
+ * @{
+ **/
+
+#include <sys/types.h>
+
+/**
+ * Obtain a file descriptor that refers to a process
+ *
+ * @note The file descriptor is opened with the close-on-exec flag set.
+ * @see PINK_HAVE_PIDFD
+ *
+ * @param pid Process ID
+ * @param flags Flags passed to @e pidfd_open(2), currently must be 0
+ * @return File descriptor on success, negated errno on failure
+ **/
+int pink_pidfd_open(pid_t pid, unsigned int flags);
+
+/**
+ * Wait for a state change of the process referred to by the file descriptor
+ *
+ * @note This function calls @e waitid(2) with @c P_PIDFD and translates the
+ *       result into a status which may be inspected using the @e wait(2)
+ *       macros and pink_event_decide().
+ * @note @c WEXITED, @c WSTOPPED and @c __WALL are always added to options.
+ * @see PINK_HAVE_PIDFD
+ *
+ * @param pidfd PID file descriptor, see pink_pidfd_open()
+ * @param status Pointer to store the status, must @b not be @e NULL
+ * @param options Additional options to @e waitid(2), eg @c WNOHANG
+ * @return Process ID on success, 0 if @c WNOHANG was specified and there
+ *         was no state change, negated errno on failure
+ **/
+pid_t pink_pidfd_wait(int pidfd, int *status, int options)
+	PINK_GCC_ATTR((nonnull(2)));
+
+/**
+ * Send a signal to the process referred to by the file descriptor
+ *
+ * @see PINK_HAVE_PIDFD
+ *
+ * @param pidfd PID file descriptor, see pink_pidfd_open()
+ * @param sig Signal
+ * @return 0 on success, negated errno on failure
+ **/
+int pink_pidfd_send_signal(int pidfd, int sig);
+
+/**
+ * Obtain a file descriptor which becomes readable when a child changes state
+ *
+ * @note This function blocks @c SIGCHLD for the calling thread. For
+ *       multithreaded tracers, block @c SIGCHLD in all threads before creating
+ *       them so the signal is not delivered elsewhere.
+ * @note The file descriptor is opened with the non-blocking and
+ *       close-on-exec flags set.
+ *
+ * @return File descriptor on success, negated errno on failure
+ **/
+int pink_sigchld_open(void);
+
+/**
+ * Drain the pending notifications of the file descriptor returned by
+ * pink_sigchld_open()
+ *
+ * @param fd File descriptor, see pink_sigchld_open()
+ * @param pids Array to store the process IDs of the children which have
+ *             changed state, may be @e NULL
+ * @param count Number of elements of the array
+ * @return Number of notifications read, which may be greater than count,
+ *         negated errno on failure
+ **/
+int pink_sigchld_read(int fd, pid_t *pids, size_t count);
+
+/** @} */
+#endif
@@ -47,6 +47,13 @@ extern "C" {
 
 #include <pinktrace/name.h>
 #include <pinktrace/pipe.h>
+#include <pinktrace/queue.h>
+#include <pinktrace/pidfd.h>
+#include <pinktrace/uring.h>
+#include <pinktrace/spawn.h>
+#include <pinktrace/sysinfo.h>
+#include <pinktrace/dispatch.h>
+#include <pinktrace/tap.h>
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,214 @@
+/*
+ * Copyright (c) 2021 Ali Polatel <alip@exherbo.org>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "pinktrace-bench.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+/*
+ * Results are written to $PINK_BENCH_OUTPUT, by default pinktrace-bench.csv,
+ * or pinktrace-bench.json if $PINK_BENCH_FORMAT is "json".
+ */
+static FILE *bench_out;
+static bool bench_json;
+static unsigned long bench_nresults;
+static double bench_scale = 1.0;
+
+static const char bench_csv_header[] =
+	"name,variant,param,count,bytes,elapsed_ns,ops_per_sec,mib_per_sec,"
+	"mean_ns,p50_ns,p90_ns,p99_ns,max_ns,cpu_ns,rss_kb,"
+	"stops,stops_per_sec,overhead_ns\n";
+
+uint64_t bench_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+uint64_t bench_cpu_time(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+unsigned long bench_iterations(uint64_t budget, size_t size)
+{
+	double count;
+
+	count = bench_scale * budget / (size ? size : 1);
+	if (count < 5)
+		return 5;
+	if (count > 100000)
+		return 100000;
+	return count;
+}
+
+unsigned long bench_count(unsigned long count)
+{
+	double scaled = bench_scale * count;
+
+	return scaled < 1 ? 1 : scaled;
+}
+
+uint64_t *bench_samples(unsigned long count)
+{
+	uint64_t *samples;
+
+	samples = malloc(count * sizeof(uint64_t));
+	if (!samples)
+		fail_verbose("malloc of %lu samples failed", count);
+	return samples;
+}
+
+static int bench_cmp(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a;
+	uint64_t y = *(const uint64_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+/* Nearest rank percentile of the sorted samples */
+static uint64_t bench_percentile(const struct bench_result *result,
+				 unsigned percent)
+{
+	size_t rank;
+
+	if (!result->nsamples)
+		return 0;
+	rank = (result->nsamples * percent + 99) / 100;
+	return result->samples[rank ? rank - 1 : 0];
+}
+
+void bench_report(struct bench_result *result)
+{
+	double secs, ops, mibs, mean, stops;
+	uint64_t p50, p90, p99, max;
+
+	if (result->nsamples)
+		qsort(result->samples, result->nsamples, sizeof(uint64_t),
+		      bench_cmp);
+	p50 = bench_percentile(result, 50);
+	p90 = bench_percentile(result, 90);
+	p99 = bench_percentile(result, 99);
+	max = result->nsamples ? result->samples[result->nsamples - 1] : 0;
+
+	secs = result->elapsed / 1e9;
+	ops = secs > 0 ? result->count / secs : 0;
+	mibs = secs > 0 ? result->bytes / secs / (1024 * 1024) : 0;
+	mean = result->count ? (double)result->elapsed / result->count : 0;
+	stops = secs > 0 ? result->stops / secs : 0;
+
+	if (!result->bytes)
+		info("\t%-20s %-10s %8lu: %10.0f ops/s %10.0f stops/s +%.0fns/op cpu:%llums\n",
+		     result->name, result->variant, result->param, ops, stops,
+		     result->overhead,
+		     (unsigned long long)result->cpu / 1000000);
+	else
+		info("\t%-20s %-10s %8lu: %10.0f ops/s %10.2f MiB/s p50:%lluns p99:%lluns\n",
+		     result->name, result->variant, result->param, ops, mibs,
+		     (unsigned long long)p50, (unsigned long long)p99);
+
+	if (!bench_out)
+		return;
+	if (bench_json) {
+		fprintf(bench_out, "%s\n  {\"name\": \"%s\", \"variant\": \"%s\", "
+			"\"param\": %lu, \"count\": %lu, \"bytes\": %llu, "
+			"\"elapsed_ns\": %llu, \"ops_per_sec\": %.2f, "
+			"\"mib_per_sec\": %.2f, \"mean_ns\": %.1f, "
+			"\"p50_ns\": %llu, \"p90_ns\": %llu, \"p99_ns\": %llu, "
+			"\"max_ns\": %llu, \"cpu_ns\": %llu, \"rss_kb\": %llu, "
+			"\"stops\": %lu, \"stops_per_sec\": %.2f, "
+			"\"overhead_ns\": %.1f}",
+			bench_nresults ? "," : "",
+			result->name, result->variant, result->param,
+			result->count, (unsigned long long)result->bytes,
+			(unsigned long long)result->elapsed, ops, mibs, mean,
+			(unsigned long long)p50, (unsigned long long)p90,
+			(unsigned long long)p99, (unsigned long long)max,
+			(unsigned long long)result->cpu,
+			(unsigned long long)result->rss,
+			result->stops, stops, result->overhead);
+	} else {
+		fprintf(bench_out, "%s,%s,%lu,%lu,%llu,%llu,%.2f,%.2f,%.1f,"
+			"%llu,%llu,%llu,%llu,%llu,%llu,%lu,%.2f,%.1f\n",
+			result->name, result->variant, result->param,
+			result->count, (unsigned long long)result->bytes,
+			(unsigned long long)result->elapsed, ops, mibs, mean,
+			(unsigned long long)p50, (unsigned long long)p90,
+			(unsigned long long)p99, (unsigned long long)max,
+			(unsigned long long)result->cpu,
+			(unsigned long long)result->rss,
+			result->stops, stops, result->overhead);
+	}
+	fflush(bench_out);
+	bench_nresults++;
+}
+
+static int bench_open(void)
+{
+	const char *format, *path, *scale;
+
+	format = getenv("PINK_BENCH_FORMAT");
+	bench_json = format && !strcmp(format, "json");
+	path = getenv("PINK_BENCH_OUTPUT");
+	if (!path)
+		path = bench_json ? "pinktrace-bench.json" : "pinktrace-bench.csv";
+	scale = getenv("PINK_BENCH_SCALE");
+	if (scale && atof(scale) > 0)
+		bench_scale = atof(scale);
+
+	bench_out = fopen(path, "w");
+	if (!bench_out) {
+		fprintf(stderr, "fopen(%s) failed (errno:%d %s)\n",
+			path, errno, strerror(errno));
+		return -1;
+	}
+	fputs(bench_json ? "[" : bench_csv_header, bench_out);
+	return 0;
+}
+
+static void bench_close(void)
+{
+	if (bench_json)
+		fputs("\n]\n", bench_out);
+	fclose(bench_out);
+}
+
+static void all_benches(void)
+{
+	const char *skip = getenv("PINK_BENCH_SKIP");
+
+	if (!skip || !strstr(skip, "vm"))
+		bench_suite_vm();
+	if (!skip || !strstr(skip, "trace"))
+		bench_suite_trace();
+	if (!skip || !strstr(skip, "scale"))
+		bench_suite_scale();
+}
+
+int main(int argc, char *argv[])
+{
+	int r;
+
+	_i = 0;
+
+	if (argc == 3 && !strcmp(argv[1], BENCH_EXEC_CHAIN))
+		return bench_exec_chain(argv[2]);
+	if (bench_open() < 0)
+		return EXIT_FAILURE;
+	r = seatest_testrunner(argc, argv, all_benches, NULL, NULL);
+	bench_close();
+
+	return r ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2021 Ali Polatel <alip@exherbo.org>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#ifndef _PINKTRACE_BENCH_H
+#define _PINKTRACE_BENCH_H
+
+#include "pinktrace-check.h"
+
+#include <stdint.h>
+
+/*
+ * Result of a benchmark, one line of CSV or one object of JSON.
+ * Zero fields are reported as such, which means "not measured".
+ */
+struct bench_result {
+	const char *name;	/* benchmark, eg. "vm_cread" */
+	const char *variant;	/* eg. "aligned", "crosspage" */
+	unsigned long param;	/* size in bytes, number of tracees, ... */
+	unsigned long count;	/* number of operations */
+	uint64_t bytes;		/* number of bytes transferred */
+	uint64_t elapsed;	/* wall clock time in nanoseconds */
+	uint64_t cpu;		/* CPU time of the benchmark in nanoseconds */
+	uint64_t rss;		/* growth of the resident set size in kilobytes */
+	unsigned long stops;	/* number of ptrace stops */
+	double overhead;	/* nanoseconds added per operation by tracing */
+	uint64_t *samples;	/* latencies in nanoseconds, sorted by report */
+	size_t nsamples;
+};
+
+/* Monotonic clock and CPU time of this process in nanoseconds */
+uint64_t bench_now(void);
+uint64_t bench_cpu_time(void);
+
+/*
+ * Number of iterations to transfer about budget bytes in chunks of size,
+ * scaled by $PINK_BENCH_SCALE.
+ */
+unsigned long bench_iterations(uint64_t budget, size_t size);
+
+/* Scale the given number of operations by $PINK_BENCH_SCALE, at least 1 */
+unsigned long bench_count(unsigned long count);
+
+/* Allocate room for count latency samples or fail the benchmark */
+uint64_t *bench_samples(unsigned long count);
+
+/* Write the result to the output file and print a summary */
+void bench_report(struct bench_result *result);
+
+/* Re-executed by the execve chain workload, see trace-BENCH.c */
+#define BENCH_EXEC_CHAIN	"exec-chain"
+int bench_exec_chain(const char *count);
+
+void bench_suite_vm(void);
+void bench_suite_trace(void);
+void bench_suite_scale(void);
+
+#endif
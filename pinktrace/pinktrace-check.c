@@ -834,6 +834,8 @@ void write_vm_data_or_kill(pid_t pid, struct pink_regset *regset, long addr, con
 	     pid, addr, (void *)src, len, r);
 }
 
+#ifndef PINKTRACE_BENCH
+/* pinktrace-bench shares the helpers above but has its own main(). */
 static unsigned get_os_release(void)
 {
 	unsigned rel;
@@ -882,6 +884,8 @@ static void all_tests(void)
 
 	if (!skip || !strstr(skip, "trace"))
 		test_suite_trace();
+	if (!skip || !strstr(skip, "name"))
+		test_suite_name();
 	if (!skip || !strstr(skip, "vm"))
 		test_suite_vm();
 	if (!skip || !strstr(skip, "read"))
@@ -892,6 +896,18 @@ static void all_tests(void)
 		test_suite_socket();
 	if (!skip || !strstr(skip, "pipe"))
 		test_suite_pipe();
+	if (!skip || !strstr(skip, "queue"))
+		test_suite_queue();
+	if (!skip || !strstr(skip, "pidfd"))
+		test_suite_pidfd();
+	if (!skip || !strstr(skip, "uring"))
+		test_suite_uring();
+	if (!skip || !strstr(skip, "spawn"))
+		test_suite_spawn();
+	if (!skip || !strstr(skip, "dispatch"))
+		test_suite_dispatch();
+	if (!skip || !strstr(skip, "tap"))
+		test_suite_tap();
 }
 
 int main(int argc, char *argv[])
@@ -903,3 +919,5 @@ int main(int argc, char *argv[])
 		return EXIT_SUCCESS;
 	return EXIT_FAILURE;
 }
+
+#endif /* !PINKTRACE_BENCH */
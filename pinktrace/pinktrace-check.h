@@ -163,10 +163,17 @@ void write_argument_or_kill(pid_t pid, struct pink_regset *regset, unsigned arg_
 void write_vm_data_or_kill(pid_t pid, struct pink_regset *regset, long addr, const char *src, size_t len);
 
 void test_suite_trace(void);
+void test_suite_name(void);
 void test_suite_vm(void);
 void test_suite_read(void);
 void test_suite_write(void);
 void test_suite_socket(void);
 void test_suite_pipe(void);
+void test_suite_queue(void);
+void test_suite_pidfd(void);
+void test_suite_uring(void);
+void test_suite_spawn(void);
+void test_suite_dispatch(void);
+void test_suite_tap(void);
 
 #endif
@@ -29,10 +29,146 @@ static void test_read_write_int(void)
 			     strerror(-r));
 }
 
+#define CHANNEL_TEST_COUNT	1000
+#define CHANNEL_TEST_RING	8192
+
+/* Length and contents of the test message number i */
+static size_t channel_msg(unsigned i, char *buf)
+{
+	size_t len = (i * 37) % 3000;
+
+	memset(buf, 'a' + i % 26, len);
+	if (len >= sizeof(i))
+		memcpy(buf, &i, sizeof(i));
+	return len;
+}
+
+/*
+ * Test whether messages arrive in order and intact:
+ * Fork a child which sends messages of varying lengths in batches, receive
+ * and check them in the parent.
+ * Over a pipe (_i = 0), check the parent gets EPIPE after the child exits.
+ * Over a ring (_i = 1), the ring is small so the child waits for space.
+ */
+static void test_channel_send_recv(void)
+{
+	int r, status;
+	pid_t pid;
+	ssize_t len;
+	unsigned i, j;
+	struct pink_channel *chan;
+	static char buf[3000], rbuf[3000];
+	int flags = _i ? PINK_CHANNEL_RING : 0;
+
+	if ((r = pink_channel_alloc(&chan, flags, CHANNEL_TEST_RING)) < 0)
+		fail_verbose("pink_channel_alloc failed: %d(%s)", -r, strerror(-r));
+
+	pid = fork_assert();
+	if (pid == 0) {
+		static char msgbuf[8][3000];
+		struct iovec iov[8];
+
+		pink_channel_close_unused(chan, true);
+		for (i = 0; i < CHANNEL_TEST_COUNT; i += 8) {
+			for (j = 0; j < 8; j++) {
+				iov[j].iov_base = msgbuf[j];
+				iov[j].iov_len = channel_msg(i + j, msgbuf[j]);
+			}
+			if (pink_channel_sendv(chan, iov, 8) != 8)
+				_exit(1);
+		}
+		_exit(0);
+	}
+
+	if ((r = pink_channel_close_unused(chan, false)) < 0)
+		fail_verbose("pink_channel_close_unused failed: %d(%s)",
+			     -r, strerror(-r));
+	for (i = 0; i < CHANNEL_TEST_COUNT; i++) {
+		len = pink_channel_recv(chan, rbuf, sizeof(rbuf));
+		if (len < 0) {
+			kill(pid, SIGKILL);
+			fail_verbose("pink_channel_recv failed for message %u: %zd(%s)",
+				     i, -len, strerror(-len));
+		}
+		if ((size_t)len != channel_msg(i, buf) || memcmp(buf, rbuf, len)) {
+			kill(pid, SIGKILL);
+			fail_verbose("message %u differs (len:%zd)", i, len);
+		}
+	}
+	waitpid_no_intr(pid, &status, 0);
+	check_exit_code_or_fail(status, 0);
+
+	if (!_i && (len = pink_channel_recv(chan, rbuf, sizeof(rbuf))) != -EPIPE)
+		fail_verbose("pink_channel_recv after exit = %zd, expected %d",
+			     len, -EPIPE);
+	pink_channel_free(chan);
+}
+
+/*
+ * Test non-blocking channels:
+ * Check receiving from an empty channel fails with EAGAIN, fill the channel
+ * until sending fails with EAGAIN, then receive every message sent, flushing
+ * the rest of a partially written one, and check a message which does not
+ * fit the receive buffer is kept.
+ * _i = 0 tests a pipe, _i = 1 tests a ring.
+ */
+static void test_channel_nonblock(void)
+{
+	int r;
+	ssize_t len;
+	unsigned i, sent;
+	struct pink_channel *chan;
+	static char buf[3000], rbuf[3000];
+	int flags = PINK_CHANNEL_NONBLOCK | (_i ? PINK_CHANNEL_RING : 0);
+
+	if ((r = pink_channel_alloc(&chan, flags, CHANNEL_TEST_RING)) < 0)
+		fail_verbose("pink_channel_alloc failed: %d(%s)", -r, strerror(-r));
+
+	if ((len = pink_channel_recv(chan, rbuf, sizeof(rbuf))) != -EAGAIN)
+		fail_verbose("pink_channel_recv on empty channel = %zd", len);
+
+	for (sent = 0; sent < 1000000; sent++) {
+		len = channel_msg(sent, buf);
+		r = pink_channel_send(chan, buf, len);
+		if (r == -EAGAIN)
+			break;
+		if (r < 0)
+			fail_verbose("pink_channel_send failed: %d(%s)",
+				     -r, strerror(-r));
+	}
+	info("\tsent %u messages before EAGAIN\n", sent);
+	if (sent == 0 || sent == 1000000)
+		fail_verbose("sent %u messages", sent);
+
+	for (i = 0; i < sent; i++) {
+		if ((r = pink_channel_flush(chan)) < 0 && r != -EAGAIN)
+			fail_verbose("pink_channel_flush failed: %d(%s)",
+				     -r, strerror(-r));
+		len = channel_msg(i, buf);
+		if (len > 0 &&
+		    (r = pink_channel_recv(chan, rbuf, len - 1)) != -EMSGSIZE)
+			fail_verbose("pink_channel_recv short buffer = %d", r);
+		len = pink_channel_recv(chan, rbuf, sizeof(rbuf));
+		if ((size_t)len != channel_msg(i, buf) || memcmp(buf, rbuf, len))
+			fail_verbose("message %u differs (len:%zd)", i, len);
+	}
+	if ((len = pink_channel_recv(chan, rbuf, sizeof(rbuf))) != -EAGAIN)
+		fail_verbose("pink_channel_recv on drained channel = %zd", len);
+
+	r = pink_channel_send(chan, buf, _i ? CHANNEL_TEST_RING : PINK_CHANNEL_MSG_MAX + 1);
+	if (r != -EMSGSIZE)
+		fail_verbose("pink_channel_send of long message = %d", r);
+	pink_channel_free(chan);
+}
+
 static void test_fixture_pipe(void) {
 	test_fixture_start();
 
 	run_test(test_read_write_int);
+	for (_i = 0; _i < 2; _i++)
+		run_test(test_channel_send_recv);
+	for (_i = 0; _i < 2; _i++)
+		run_test(test_channel_nonblock);
 
 	test_fixture_end();
 }
@@ -7,7 +7,10 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <poll.h>
 #include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
 
 #include <pinktrace/pink.h>
 
@@ -125,3 +128,466 @@ int pink_pipe_write_int(int fd, int i)
 		return errno ? -errno : -EINVAL;
 	return 0;
 }
+
+/*
+ * Message channels
+ *
+ * Every message is preceded by its length as a 32 bit integer. Over a pipe,
+ * the receiver reads as much as fits into its buffer and hands out messages
+ * from there. Over a ring, frames are aligned to 8 bytes and a frame of
+ * length CHANNEL_PAD marks the rest of the ring as unused.
+ */
+#define CHANNEL_BATCH	64
+#define CHANNEL_BUFSIZ	(sizeof(uint32_t) + PINK_CHANNEL_MSG_MAX)
+#define CHANNEL_PAD	UINT32_MAX
+#define CHANNEL_ALIGN(len)	(((len) + 7) & ~(size_t)7)
+#define CHANNEL_FRAME(len)	CHANNEL_ALIGN(sizeof(uint32_t) + (len))
+
+/*
+ * Start of the shared memory mapping of a ring, followed by the data.
+ * head is only written by the sender and tail only by the receiver.
+ * Either side sets its waiting flag before it sleeps on its eventfd and the
+ * other side signals the eventfd only if it finds the flag set.
+ */
+struct channel_ring {
+	uint64_t head;
+	uint32_t reader_waiting;
+	char pad0[PINK_CACHELINE_SIZE - sizeof(uint64_t) - sizeof(uint32_t)];
+	uint64_t tail;
+	uint32_t writer_waiting;
+	char pad1[PINK_CACHELINE_SIZE - sizeof(uint64_t) - sizeof(uint32_t)];
+};
+
+struct pink_channel {
+	int flags;
+	int pipefd[2];
+
+	/* receive buffer of a pipe, allocated on first use */
+	char *buf;
+	size_t start, end;
+	/* rest of a partially written message in non-blocking mode */
+	char *wbuf;
+	size_t wpos, wlen;
+
+	struct channel_ring *ring;
+	char *data;
+	size_t size;
+	int data_efd, space_efd;
+};
+
+int pink_channel_alloc(struct pink_channel **chanptr, int flags,
+		       size_t ring_size)
+{
+	int r, efd_flags;
+	struct pink_channel *chan;
+
+	chan = calloc(1, sizeof(struct pink_channel));
+	if (!chan)
+		return -ENOMEM;
+	chan->flags = flags;
+	chan->pipefd[0] = chan->pipefd[1] = -1;
+	chan->data_efd = chan->space_efd = -1;
+
+	if (!(flags & PINK_CHANNEL_RING)) {
+		if ((r = pink_pipe_init(chan->pipefd)) < 0)
+			goto fail;
+		if ((flags & PINK_CHANNEL_NONBLOCK) &&
+		    (fcntl(chan->pipefd[0], F_SETFL, O_NONBLOCK) < 0 ||
+		     fcntl(chan->pipefd[1], F_SETFL, O_NONBLOCK) < 0)) {
+			r = -errno;
+			goto fail;
+		}
+		*chanptr = chan;
+		return 0;
+	}
+
+	if (ring_size == 0 || ring_size % 8 != 0 ||
+	    ring_size > UINT32_MAX) {
+		r = -EINVAL;
+		goto fail;
+	}
+	chan->ring = mmap(NULL, sizeof(struct channel_ring) + ring_size,
+			  PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS,
+			  -1, 0);
+	if (chan->ring == MAP_FAILED) {
+		chan->ring = NULL;
+		r = -errno;
+		goto fail;
+	}
+	chan->data = (char *)(chan->ring + 1);
+	chan->size = ring_size;
+
+	efd_flags = EFD_CLOEXEC;
+	if (flags & PINK_CHANNEL_NONBLOCK)
+		efd_flags |= EFD_NONBLOCK;
+	if ((chan->data_efd = eventfd(0, efd_flags)) < 0 ||
+	    (chan->space_efd = eventfd(0, efd_flags)) < 0) {
+		r = -errno;
+		goto fail;
+	}
+
+	*chanptr = chan;
+	return 0;
+fail:
+	pink_channel_free(chan);
+	return r;
+}
+
+void pink_channel_free(struct pink_channel *chan)
+{
+	if (!chan)
+		return;
+
+	if (chan->pipefd[0] >= 0)
+		close(chan->pipefd[0]);
+	if (chan->pipefd[1] >= 0)
+		close(chan->pipefd[1]);
+	if (chan->data_efd >= 0)
+		close(chan->data_efd);
+	if (chan->space_efd >= 0)
+		close(chan->space_efd);
+	if (chan->ring)
+		munmap(chan->ring, sizeof(struct channel_ring) + chan->size);
+	free(chan->buf);
+	free(chan->wbuf);
+	free(chan);
+}
+
+PINK_GCC_ATTR((nonnull(1)))
+int pink_channel_close_unused(struct pink_channel *chan, bool writer)
+{
+	int *fdptr;
+
+	/* Both sides of a ring signal each other through the eventfds. */
+	if (chan->flags & PINK_CHANNEL_RING)
+		return 0;
+
+	fdptr = &chan->pipefd[writer ? 0 : 1];
+	if (*fdptr < 0)
+		return 0;
+	if (close(*fdptr) < 0)
+		return -errno;
+	*fdptr = -1;
+	return 0;
+}
+
+PINK_GCC_ATTR((nonnull(1)))
+int pink_channel_fd(const struct pink_channel *chan)
+{
+	return (chan->flags & PINK_CHANNEL_RING) ? chan->data_efd
+						 : chan->pipefd[0];
+}
+
+/* Write the rest of a message which was written partially. */
+static int pipe_flush(struct pink_channel *chan)
+{
+	ssize_t written;
+
+	while (chan->wpos < chan->wlen) {
+		written = write(chan->pipefd[1], chan->wbuf + chan->wpos,
+				chan->wlen - chan->wpos);
+		if (written < 0) {
+			if (errno == EINTR)
+				continue;
+			return -errno;
+		}
+		chan->wpos += written;
+	}
+	chan->wpos = chan->wlen = 0;
+	return 0;
+}
+
+/*
+ * Write a batch of at most CHANNEL_BATCH messages with writev(2).
+ * Return the number of messages sent.
+ * In non-blocking mode, the rest of a message which was written partially
+ * is kept in the channel and written by the next call, so that the stream
+ * stays framed.
+ */
+static ssize_t pipe_sendv(struct pink_channel *chan,
+			  const struct iovec *msgs, size_t count)
+{
+	int r;
+	size_t i, n = 0;
+	ssize_t written;
+	uint32_t lens[CHANNEL_BATCH];
+	struct iovec iov[2 * CHANNEL_BATCH];
+
+	if ((r = pipe_flush(chan)) < 0)
+		return r;
+
+	for (i = 0; i < count; i++) {
+		lens[i] = msgs[i].iov_len;
+		iov[2 * i].iov_base = &lens[i];
+		iov[2 * i].iov_len = sizeof(uint32_t);
+		iov[2 * i + 1] = msgs[i];
+	}
+	count *= 2;
+
+	while (n < count) {
+		written = writev(chan->pipefd[1], iov + n, count - n);
+		if (written < 0) {
+			if (errno == EINTR)
+				continue;
+			/* At a message boundary, leave the rest to the caller. */
+			if (errno != EAGAIN ||
+			    (n % 2 == 0 && iov[n].iov_len == sizeof(uint32_t)))
+				return n / 2 ? (ssize_t)(n / 2) : -errno;
+			if (!chan->wbuf && !(chan->wbuf = malloc(CHANNEL_BUFSIZ)))
+				return n / 2 ? (ssize_t)(n / 2) : -ENOMEM;
+			for (; n < count && (n % 2 || !chan->wlen); n++) {
+				memcpy(chan->wbuf + chan->wlen, iov[n].iov_base,
+				       iov[n].iov_len);
+				chan->wlen += iov[n].iov_len;
+			}
+			return n / 2;
+		}
+		while (n < count && (size_t)written >= iov[n].iov_len) {
+			written -= iov[n].iov_len;
+			n++;
+		}
+		if (n < count) {
+			iov[n].iov_base = (char *)iov[n].iov_base + written;
+			iov[n].iov_len -= written;
+		}
+	}
+
+	return count / 2;
+}
+
+static void ring_signal(uint32_t *waiting, int efd)
+{
+	uint64_t one = 1;
+
+	if (__atomic_exchange_n(waiting, 0, __ATOMIC_SEQ_CST)) {
+		while (write(efd, &one, sizeof(one)) < 0 && errno == EINTR)
+			;
+	}
+}
+
+static int ring_wait(int efd)
+{
+	uint64_t count;
+
+	if (read(efd, &count, sizeof(count)) < 0 && errno != EINTR)
+		return -errno;
+	return 0;
+}
+
+/*
+ * Check whether need bytes are free in the ring,
+ * announce we are about to wait on the eventfd if they are not.
+ */
+static bool ring_space(struct pink_channel *chan, uint64_t head, size_t need,
+		       bool announce)
+{
+	uint64_t tail;
+
+	tail = __atomic_load_n(&chan->ring->tail, __ATOMIC_ACQUIRE);
+	if (chan->size - (head - tail) >= need || !announce)
+		return chan->size - (head - tail) >= need;
+
+	__atomic_store_n(&chan->ring->writer_waiting, 1, __ATOMIC_SEQ_CST);
+	tail = __atomic_load_n(&chan->ring->tail, __ATOMIC_SEQ_CST);
+	return chan->size - (head - tail) >= need;
+}
+
+static ssize_t ring_sendv(struct pink_channel *chan,
+			  const struct iovec *msgs, size_t count)
+{
+	int r;
+	size_t i, pos, room, need, want;
+	uint64_t head;
+	uint32_t len;
+
+	head = chan->ring->head;
+	for (i = 0; i < count;) {
+		pos = head % chan->size;
+		room = chan->size - pos;
+		need = CHANNEL_FRAME(msgs[i].iov_len);
+		if (need > chan->size)
+			break;
+
+		/* Frames do not wrap, pad the rest of the ring instead. */
+		want = MIN(room, need);
+		if (!ring_space(chan, head, want, false)) {
+			__atomic_store_n(&chan->ring->head, head, __ATOMIC_SEQ_CST);
+			ring_signal(&chan->ring->reader_waiting, chan->data_efd);
+			if (chan->flags & PINK_CHANNEL_NONBLOCK)
+				break;
+			if (!ring_space(chan, head, want, true) &&
+			    (r = ring_wait(chan->space_efd)) < 0)
+				return i ? (ssize_t)i : r;
+			continue;
+		}
+
+		if (room < need) {
+			len = CHANNEL_PAD;
+			memcpy(chan->data + pos, &len, sizeof(len));
+			head += room;
+			continue;
+		}
+		len = msgs[i].iov_len;
+		memcpy(chan->data + pos, &len, sizeof(len));
+		memcpy(chan->data + pos + sizeof(len), msgs[i].iov_base, len);
+		head += need;
+		i++;
+	}
+
+	__atomic_store_n(&chan->ring->head, head, __ATOMIC_SEQ_CST);
+	ring_signal(&chan->ring->reader_waiting, chan->data_efd);
+
+	if (i == 0 && count > 0)
+		return CHANNEL_FRAME(msgs[0].iov_len) > chan->size ? -EMSGSIZE
+								   : -EAGAIN;
+	return i;
+}
+
+PINK_GCC_ATTR((nonnull(1)))
+ssize_t pink_channel_sendv(struct pink_channel *chan,
+			   const struct iovec *msgs, size_t count)
+{
+	size_t i, sent = 0;
+	ssize_t r;
+
+	if (chan->flags & PINK_CHANNEL_RING)
+		return ring_sendv(chan, msgs, count);
+
+	while (sent < count) {
+		size_t batch = MIN(count - sent, CHANNEL_BATCH);
+
+		for (i = 0; i < batch; i++) {
+			if (msgs[sent + i].iov_len > PINK_CHANNEL_MSG_MAX) {
+				batch = i;
+				break;
+			}
+		}
+		if (batch == 0)
+			return sent ? (ssize_t)sent : -EMSGSIZE;
+
+		r = pipe_sendv(chan, msgs + sent, batch);
+		if (r < 0)
+			return sent ? (ssize_t)sent : r;
+		sent += r;
+		if ((size_t)r < batch)
+			break;
+	}
+
+	return sent;
+}
+
+PINK_GCC_ATTR((nonnull(1)))
+int pink_channel_flush(struct pink_channel *chan)
+{
+	if (chan->flags & PINK_CHANNEL_RING)
+		return 0;
+	return pipe_flush(chan);
+}
+
+PINK_GCC_ATTR((nonnull(1)))
+int pink_channel_send(struct pink_channel *chan, const void *buf, size_t len)
+{
+	ssize_t r;
+	struct iovec iov = { .iov_base = (void *)buf, .iov_len = len };
+
+	r = pink_channel_sendv(chan, &iov, 1);
+	return r < 0 ? (int)r : 0;
+}
+
+static ssize_t pipe_recv(struct pink_channel *chan, void *buf, size_t len)
+{
+	size_t avail;
+	ssize_t count;
+	uint32_t msglen;
+
+	if (!chan->buf && !(chan->buf = malloc(CHANNEL_BUFSIZ)))
+		return -ENOMEM;
+
+	for (;;) {
+		avail = chan->end - chan->start;
+		if (avail >= sizeof(uint32_t)) {
+			memcpy(&msglen, chan->buf + chan->start, sizeof(uint32_t));
+			if (msglen > PINK_CHANNEL_MSG_MAX)
+				return -EPROTO;
+			if (msglen > len)
+				return -EMSGSIZE;
+			if (avail >= sizeof(uint32_t) + msglen) {
+				memcpy(buf, chan->buf + chan->start + sizeof(uint32_t),
+				       msglen);
+				chan->start += sizeof(uint32_t) + msglen;
+				return msglen;
+			}
+		}
+
+		if (chan->start > 0) {
+			memmove(chan->buf, chan->buf + chan->start, avail);
+			chan->start = 0;
+			chan->end = avail;
+		}
+		count = read(chan->pipefd[0], chan->buf + chan->end,
+			     CHANNEL_BUFSIZ - chan->end);
+		if (count < 0) {
+			if (errno == EINTR)
+				continue;
+			return -errno;
+		} else if (count == 0) {
+			return avail ? -EPROTO : -EPIPE;
+		}
+		chan->end += count;
+	}
+}
+
+static ssize_t ring_recv(struct pink_channel *chan, void *buf, size_t len)
+{
+	int r;
+	size_t pos;
+	uint64_t head, tail, count;
+	uint32_t msglen;
+	bool nonblock = chan->flags & PINK_CHANNEL_NONBLOCK;
+
+	tail = chan->ring->tail;
+	for (;;) {
+		head = __atomic_load_n(&chan->ring->head, __ATOMIC_ACQUIRE);
+		if (head == tail) {
+			if (nonblock) {
+				/* Consume stale signals so poll(2) blocks. */
+				if (read(chan->data_efd, &count, sizeof(count)) > 0)
+					continue;
+			}
+			__atomic_store_n(&chan->ring->reader_waiting, 1,
+					 __ATOMIC_SEQ_CST);
+			if (__atomic_load_n(&chan->ring->head, __ATOMIC_SEQ_CST) != tail)
+				continue;
+			if (nonblock)
+				return -EAGAIN;
+			if ((r = ring_wait(chan->data_efd)) < 0)
+				return r;
+			continue;
+		}
+
+		pos = tail % chan->size;
+		memcpy(&msglen, chan->data + pos, sizeof(msglen));
+		if (msglen == CHANNEL_PAD) {
+			tail += chan->size - pos;
+		} else if (CHANNEL_FRAME(msglen) > chan->size - pos) {
+			return -EPROTO;
+		} else {
+			if (msglen > len)
+				return -EMSGSIZE;
+			memcpy(buf, chan->data + pos + sizeof(msglen), msglen);
+			tail += CHANNEL_FRAME(msglen);
+		}
+		__atomic_store_n(&chan->ring->tail, tail, __ATOMIC_SEQ_CST);
+		ring_signal(&chan->ring->writer_waiting, chan->space_efd);
+		if (msglen != CHANNEL_PAD)
+			return msglen;
+	}
+}
+
+PINK_GCC_ATTR((nonnull(1)))
+ssize_t pink_channel_recv(struct pink_channel *chan, void *buf, size_t len)
+{
+	if (chan->flags & PINK_CHANNEL_RING)
+		return ring_recv(chan, buf, len);
+	return pipe_recv(chan, buf, len);
+}
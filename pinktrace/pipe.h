@@ -12,11 +12,24 @@
  *
  * Do not include this header directly, use pinktrace/pink.h instead.
  *
- * @defgroup pink_fork Pink's pipe() helpers
+ * Besides plain pipes, this module provides message channels for processes
+ * which exchange more than a few integers, eg. a tracer and its helpers.
+ * A channel carries length prefixed messages either over a pipe, where
+ * several messages are written with a single @e writev(2) and read with a
+ * single @e read(2), or over a ring in a shared memory mapping, where the
+ * messages are copied without system calls and an @e eventfd(2) is only
+ * signaled when the other side waits.
+ *
+ * @defgroup pink_pipe Pink's pipe() helpers
  * @ingroup pinktrace
  * @{
  **/
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
 /**
  * Create pipe
  *
@@ -54,5 +67,135 @@ int pink_pipe_read_int(int fd, int *i)
  **/
 int pink_pipe_write_int(int fd, int i);
 
+/** Do not block on sending or receiving, fail with @c -EAGAIN instead */
+#define PINK_CHANNEL_NONBLOCK	(1 << 0)
+/** Transfer messages over a shared memory ring rather than a pipe */
+#define PINK_CHANNEL_RING	(1 << 1)
+
+/** Maximum length of a message sent over a pipe */
+#define PINK_CHANNEL_MSG_MAX	65536
+
+/**
+ * This opaque structure represents a message channel.
+ **/
+struct pink_channel;
+
+/**
+ * Allocate a message channel
+ *
+ * The channel is meant to be allocated before @e fork(2), after which one
+ * process sends and the other one receives.
+ *
+ * @note A channel has a single sender and a single receiver. Over a pipe,
+ *       batches of messages longer than @c PIPE_BUF may interleave with the
+ *       writes of other processes.
+ * @note Over a ring, the receiver can not notice the sender has exited.
+ *
+ * @param chanptr Pointer to store the dynamically allocated channel,
+ *                Use pink_channel_free() to free after use.
+ * @param flags Bitwise OR'ed PINK_CHANNEL_NONBLOCK and PINK_CHANNEL_RING
+ * @param ring_size Size of the ring in bytes, a multiple of 8, a message
+ *                  takes its length plus four bytes rounded up to 8;
+ *                  ignored without PINK_CHANNEL_RING
+ * @return 0 on success, negated errno on failure
+ **/
+int pink_channel_alloc(struct pink_channel **chanptr, int flags,
+		       size_t ring_size)
+	PINK_GCC_ATTR((nonnull(1)));
+
+/**
+ * Close the file descriptors and unmap the ring of the channel and free it
+ *
+ * @param chan Channel
+ **/
+void pink_channel_free(struct pink_channel *chan);
+
+/**
+ * Close the end of the channel which is not used by this process
+ *
+ * Call this once in each process after @e fork(2), so that the receiver
+ * gets @c -EPIPE once the sender closes its end of a pipe.
+ *
+ * @param chan Channel
+ * @param writer True in the sending process, false in the receiving one
+ * @return 0 on success, negated errno on failure
+ **/
+int pink_channel_close_unused(struct pink_channel *chan, bool writer)
+	PINK_GCC_ATTR((nonnull(1)));
+
+/**
+ * Return the file descriptor which becomes readable when messages arrive
+ *
+ * In non-blocking mode, wait for this file descriptor with @e poll(2) after
+ * pink_channel_recv() fails with @c -EAGAIN.
+ *
+ * @param chan Channel
+ * @return File descriptor
+ **/
+int pink_channel_fd(const struct pink_channel *chan)
+	PINK_GCC_ATTR((nonnull(1)));
+
+/**
+ * Send a batch of messages
+ *
+ * Over a pipe, messages are written with one @e writev(2) per up to 64
+ * messages. Over a ring, the receiver is signaled at most once per batch.
+ * In non-blocking mode, if the pipe fills up in the middle of a message,
+ * the rest of it is kept in the channel and written by the next call to
+ * pink_channel_sendv(), pink_channel_send() or pink_channel_flush().
+ *
+ * @param chan Channel
+ * @param msgs Array of messages, one @c struct @c iovec each
+ * @param count Number of messages
+ * @return Number of messages sent, which is less than @e count if sending
+ *         the next message would block or failed; negated errno if no
+ *         message was sent, @c -EMSGSIZE if the first message is too long
+ **/
+ssize_t pink_channel_sendv(struct pink_channel *chan,
+			   const struct iovec *msgs, size_t count)
+	PINK_GCC_ATTR((nonnull(1)));
+
+/**
+ * Write the rest of a message which was sent partially in non-blocking mode
+ *
+ * Call this when the write end of the pipe becomes writable.
+ *
+ * @param chan Channel
+ * @return 0 on success, negated errno on failure, @c -EAGAIN if the rest
+ *         could not be written entirely
+ **/
+int pink_channel_flush(struct pink_channel *chan)
+	PINK_GCC_ATTR((nonnull(1)));
+
+/**
+ * Send a message
+ *
+ * @param chan Channel
+ * @param buf Message
+ * @param len Length of the message
+ * @return 0 on success, negated errno on failure
+ **/
+int pink_channel_send(struct pink_channel *chan, const void *buf, size_t len)
+	PINK_GCC_ATTR((nonnull(1)));
+
+/**
+ * Receive a message
+ *
+ * Over a pipe, as many messages as are available are read at once and
+ * buffered for the following calls.
+ *
+ * @param chan Channel
+ * @param buf Buffer to store the message
+ * @param len Length of the buffer
+ * @return Length of the message on success, negated errno on failure:
+ *         @c -EAGAIN if no message is available in non-blocking mode,
+ *         @c -EMSGSIZE if the message is longer than @e len in which case
+ *         it is kept for the next call, @c -EPIPE if the sender closed a
+ *         pipe, @c -EPROTO if the sender closed a pipe in the middle of a
+ *         message
+ **/
+ssize_t pink_channel_recv(struct pink_channel *chan, void *buf, size_t len)
+	PINK_GCC_ATTR((nonnull(1)));
+
 /** @} */
 #endif
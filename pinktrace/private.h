@@ -16,6 +16,7 @@
 #include <string.h>
 #include <unistd.h>
 #include <limits.h>
+#include <stdint.h>
 #include <errno.h>
 #include <sys/types.h>
 #include <sys/socket.h>
@@ -71,6 +72,10 @@
 #define ARRAY_SIZE(a)	(sizeof(a) / sizeof(a[0]))
 #endif
 
+#ifndef PINK_CACHELINE_SIZE
+#define PINK_CACHELINE_SIZE	64
+#endif
+
 #ifndef MIN
 #define MIN(a,b)	(((a) < (b)) ? (a) : (b))
 #endif
@@ -120,30 +125,47 @@
 # define ABI0_WORDSIZE (int)(sizeof(long))
 #endif
 
-extern const char *const errnoent0[];
-extern const char *const signalent0[];
-extern const char *const sysent0[];
+/*
+ * Sizes of the rows of the name tables, see name.c.
+ * The longest names are "sched_rr_get_interval_time64",
+ * "ERESTART_RESTARTBLOCK", "SIGSTKFLT" and "AF_IEEE802154".
+ */
+#define SYSCALL_NAME_SIZE	32
+#define ERRNO_NAME_SIZE		24
+#define SIGNAL_NAME_SIZE	16
+#define XLAT_NAME_SIZE		16
+
+/* Personalities share the errno and signal tables of the native ABI. */
+extern const char errnoent0[][ERRNO_NAME_SIZE];
+extern const char signalent0[][SIGNAL_NAME_SIZE];
+extern const char sysent0[][SYSCALL_NAME_SIZE];
 extern const size_t nerrnos0;
 extern const size_t nsignals0;
 extern const size_t nsyscalls0;
 
 #if PINK_ABIS_SUPPORTED > 1
-extern const char *const errnoent1[];
-extern const char *const signalent1[];
-extern const char *const sysent1[];
-extern const size_t nerrnos1;
-extern const size_t nsignals1;
+extern const char sysent1[][SYSCALL_NAME_SIZE];
 extern const size_t nsyscalls1;
 # if PINK_ABIS_SUPPORTED > 2
-extern const char *const errnoent2[];
-extern const char *const signalent2[];
-extern const char *const sysent2[];
-extern const size_t nerrnos2;
-extern const size_t nsignals2;
+extern const char sysent2[][SYSCALL_NAME_SIZE];
 extern const size_t nsyscalls2;
 # endif
 #endif
 
+/*
+ * Index of names sorted for binary search, built on first use, see name.c
+ */
+struct name_index {
+	uint16_t *sorted;
+};
+long name_index_lookup(struct name_index *index, const void *base,
+		       size_t stride, size_t n, const char *name);
+
+/* Convert between system call numbers and name table indexes, see name.c */
+long syscall_index(long scno);
+long syscall_number(long index);
+const char (*syscall_table(short abi, size_t *countptr))[SYSCALL_NAME_SIZE];
+
 #if PINK_ARCH_AARCH64
 struct arm_pt_regs {
 	uint32_t uregs[18];
@@ -206,4 +228,14 @@ struct pink_regset {
 	short abi;
 };
 
+/* Convert PINK_TRACE_OPTION_* flags to PTRACE_O_* flags, see trace.c */
+int trace_options(int options, int *ptrace_optionsptr);
+
+/* Shared by pink_pidfd_wait() and the io_uring backend, see pidfd.c */
+int siginfo_to_status(const siginfo_t *info, int *status);
+
+/* Gather remote buffers into dest with process_vm_readv(2), see vm.c */
+ssize_t vm_cgather(pid_t pid, char *dest, size_t len,
+		   const struct iovec *remote, size_t count);
+
 #endif
@@ -0,0 +1,242 @@
+/*
+ * Copyright (c) 2021 Ali Polatel <alip@exherbo.org>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "pinktrace-check.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#define QUEUE_THREADS	4
+#define QUEUE_ITEMS	10000
+
+static const unsigned int test_options = PINK_TRACE_OPTION_SYSGOOD;
+
+static void queue_alloc_or_fail(struct pink_queue **queueptr, size_t size)
+{
+	int r;
+
+	if ((r = pink_queue_alloc(queueptr, size)) < 0)
+		fail_verbose("pink_queue_alloc (size:%zu errno:%d %s)",
+			     size, -r, strerror(-r));
+}
+
+static void *queue_pop_wait(struct pink_queue *queue)
+{
+	void *item;
+
+	while (pink_queue_pop(queue, &item) == -EAGAIN)
+		sched_yield();
+	return item;
+}
+
+static void queue_push_wait(struct pink_queue *queue, void *item)
+{
+	while (pink_queue_push(queue, item) == -EAGAIN)
+		sched_yield();
+}
+
+/*
+ * Test whether the queue works in a single thread:
+ * Fill the queue, check that it rejects further items, then drain it and
+ * check the items arrive in order.
+ */
+static void test_queue_push_pop(void)
+{
+	int r;
+	uintptr_t i;
+	void *item;
+	struct pink_queue *queue;
+
+	if (pink_queue_alloc(&queue, 3) != -EINVAL)
+		fail_verbose("pink_queue_alloc accepted size not a power of two");
+	queue_alloc_or_fail(&queue, 4);
+
+	for (i = 1; i <= 4; i++) {
+		if ((r = pink_queue_push(queue, (void *)i)) < 0)
+			fail_verbose("pink_queue_push (item:%lu errno:%d %s)",
+				     (unsigned long)i, -r, strerror(-r));
+	}
+	if (pink_queue_push(queue, (void *)i) != -EAGAIN)
+		fail_verbose("pink_queue_push didn't fail on full queue");
+
+	for (i = 1; i <= 4; i++) {
+		if ((r = pink_queue_pop(queue, &item)) < 0)
+			fail_verbose("pink_queue_pop (errno:%d %s)", -r, strerror(-r));
+		if ((uintptr_t)item != i)
+			fail_verbose("pink_queue_pop returned item %lu, expected %lu",
+				     (unsigned long)(uintptr_t)item, (unsigned long)i);
+	}
+	if (pink_queue_pop(queue, &item) != -EAGAIN)
+		fail_verbose("pink_queue_pop didn't fail on empty queue");
+
+	pink_queue_free(queue);
+}
+
+static void *queue_producer(void *arg)
+{
+	uintptr_t i;
+	struct pink_queue *queue = arg;
+
+	for (i = 1; i <= QUEUE_ITEMS; i++)
+		queue_push_wait(queue, (void *)i);
+	return NULL;
+}
+
+static void *queue_consumer(void *arg)
+{
+	unsigned i;
+	uintptr_t sum = 0;
+	struct pink_queue *queue = arg;
+
+	for (i = 0; i < QUEUE_ITEMS; i++)
+		sum += (uintptr_t)queue_pop_wait(queue);
+	return (void *)sum;
+}
+
+/*
+ * Test whether the queue works with multiple producers and consumers:
+ * Push the same sequence of items from each producer and check the sum of
+ * items the consumers have popped.
+ */
+static void test_queue_threads(void)
+{
+	unsigned i;
+	uintptr_t sum, expected;
+	void *retval;
+	pthread_t producer[QUEUE_THREADS], consumer[QUEUE_THREADS];
+	struct pink_queue *queue;
+
+	queue_alloc_or_fail(&queue, 64);
+
+	for (i = 0; i < QUEUE_THREADS; i++) {
+		if (pthread_create(&consumer[i], NULL, queue_consumer, queue) ||
+		    pthread_create(&producer[i], NULL, queue_producer, queue))
+			fail_verbose("pthread_create (errno:%d %s)",
+				     errno, strerror(errno));
+	}
+
+	sum = 0;
+	for (i = 0; i < QUEUE_THREADS; i++) {
+		pthread_join(producer[i], NULL);
+		pthread_join(consumer[i], &retval);
+		sum += (uintptr_t)retval;
+	}
+
+	expected = QUEUE_THREADS * ((uintptr_t)QUEUE_ITEMS * (QUEUE_ITEMS + 1) / 2);
+	if (sum != expected)
+		fail_verbose("sum of popped items %lu, expected %lu",
+			     (unsigned long)sum, (unsigned long)expected);
+
+	pink_queue_free(queue);
+}
+
+struct offload {
+	struct pink_queue *submit;
+	struct pink_queue *complete;
+	const char *expstr;
+};
+
+static void *offload_worker(void *arg)
+{
+	ssize_t r;
+	char buf[64];
+	struct offload *o = arg;
+	struct pink_frame *frame;
+
+	frame = queue_pop_wait(o->submit);
+	r = pink_read_vm_data_nul(frame->pid, frame->regset, frame->args[0],
+				  buf, sizeof(buf));
+	frame->decision = (r > 0 && !strcmp(buf, o->expstr)) ? 1 : -1;
+	queue_push_wait(o->complete, frame);
+	return NULL;
+}
+
+/*
+ * Test whether decoding can be offloaded to a worker thread:
+ * First fork a new child and call syscall(PINK_SYSCALL_INVALID, ...) with a
+ * string argument, capture the frame at system call entry and pass it to a
+ * worker thread which reads the string and sends back its decision.
+ */
+static void test_queue_offload(void)
+{
+	int r;
+	pid_t pid;
+	bool it_worked = false;
+	pthread_t worker;
+	struct pink_regset *regset;
+	struct pink_frame *frame;
+	struct offload o;
+
+	o.expstr = "pink floyd";
+	queue_alloc_or_fail(&o.submit, 2);
+	queue_alloc_or_fail(&o.complete, 2);
+	if ((r = pink_frame_alloc(&frame)) < 0)
+		fail_verbose("pink_frame_alloc (errno:%d %s)", -r, strerror(-r));
+	if (pthread_create(&worker, NULL, offload_worker, &o))
+		fail_verbose("pthread_create (errno:%d %s)", errno, strerror(errno));
+
+	pid = fork_assert();
+	if (pid == 0) {
+		trace_me_and_stop();
+		syscall(PINK_SYSCALL_INVALID, o.expstr, 0, 0, 0, 0, 0);
+		_exit(0);
+	}
+	regset_alloc_or_kill(pid, &regset);
+
+	LOOP_WHILE_TRUE() {
+		int status;
+		pid_t tracee_pid;
+
+		tracee_pid = wait_verbose(&status);
+		if (tracee_pid <= 0 && check_echild_or_kill(pid, tracee_pid))
+			break;
+		if (check_exit_code_or_fail(status, 0))
+			break;
+		check_signal_or_fail(status, 0);
+		check_stopped_or_kill(tracee_pid, status);
+		if (WSTOPSIG(status) == SIGSTOP) {
+			trace_setup_or_kill(pid, test_options);
+		} else if (WSTOPSIG(status) == (SIGTRAP|0x80)) {
+			regset_fill_or_kill(pid, regset);
+			if ((r = pink_frame_capture(pid, regset, frame)) < 0) {
+				kill(pid, SIGKILL);
+				fail_verbose("pink_frame_capture (pid:%u errno:%d %s)",
+					     pid, -r, strerror(-r));
+				break;
+			}
+			check_syscall_equal_or_kill(pid, frame->sysnum,
+						    PINK_SYSCALL_INVALID);
+			queue_push_wait(o.submit, frame);
+			frame = queue_pop_wait(o.complete);
+			it_worked = frame->decision == 1;
+			kill(pid, SIGKILL);
+			break;
+		}
+		trace_syscall_or_kill(pid, 0);
+	}
+
+	pthread_join(worker, NULL);
+	pink_frame_free(frame);
+	pink_regset_free(regset);
+	pink_queue_free(o.submit);
+	pink_queue_free(o.complete);
+
+	if (!it_worked)
+		fail_verbose("Test for offloading decoding to a worker thread failed");
+}
+
+static void test_fixture_queue(void) {
+	test_fixture_start();
+
+	run_test(test_queue_push_pop);
+	run_test(test_queue_threads);
+	run_test(test_queue_offload);
+
+	test_fixture_end();
+}
+
+void test_suite_queue(void) {
+	test_fixture_queue();
+}
@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2021 Ali Polatel <alip@exherbo.org>
+ * Based in part upon the bounded MPMC queue by Dmitry Vyukov which is:
+ *   Copyright (c) 2010-2011 Dmitry Vyukov
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include <pinktrace/private.h>
+#include <pinktrace/pink.h>
+
+/*
+ * Each cell carries a sequence number which tells producers and consumers
+ * whose turn it is: a cell at position pos is free for the producer when
+ * seq == pos and holds an item for the consumer when seq == pos + 1.
+ * Producers and consumers only contend on their own position counter, so
+ * keep the two counters on different cache lines.
+ */
+struct pink_queue_cell {
+	size_t seq;
+	void *item;
+};
+
+struct pink_queue {
+	size_t mask;
+	struct pink_queue_cell *cells;
+	char pad0[PINK_CACHELINE_SIZE - sizeof(size_t) - sizeof(void *)];
+	size_t head; /* enqueue position */
+	char pad1[PINK_CACHELINE_SIZE - sizeof(size_t)];
+	size_t tail; /* dequeue position */
+	char pad2[PINK_CACHELINE_SIZE - sizeof(size_t)];
+};
+
+PINK_GCC_ATTR((nonnull(1)))
+int pink_queue_alloc(struct pink_queue **queueptr, size_t size)
+{
+	size_t i;
+	struct pink_queue *q;
+
+	if (size < 2 || (size & (size - 1)) != 0)
+		return -EINVAL;
+
+	q = calloc(1, sizeof(struct pink_queue));
+	if (!q)
+		return -errno;
+	q->cells = calloc(size, sizeof(struct pink_queue_cell));
+	if (!q->cells) {
+		int save_errno = errno;
+		free(q);
+		return -save_errno;
+	}
+
+	q->mask = size - 1;
+	for (i = 0; i < size; i++)
+		q->cells[i].seq = i;
+
+	*queueptr = q;
+	return 0;
+}
+
+void pink_queue_free(struct pink_queue *queue)
+{
+	if (!queue)
+		return;
+	free(queue->cells);
+	free(queue);
+}
+
+PINK_GCC_ATTR((nonnull(1)))
+int pink_queue_push(struct pink_queue *queue, void *item)
+{
+	size_t pos, seq;
+	intptr_t diff;
+	struct pink_queue_cell *cell;
+
+	pos = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+	for (;;) {
+		cell = &queue->cells[pos & queue->mask];
+		seq = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
+		diff = (intptr_t)seq - (intptr_t)pos;
+		if (diff == 0) {
+			if (__atomic_compare_exchange_n(&queue->head, &pos, pos + 1,
+							true, __ATOMIC_RELAXED,
+							__ATOMIC_RELAXED))
+				break;
+		} else if (diff < 0) {
+			return -EAGAIN; /* full */
+		} else {
+			pos = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+		}
+	}
+
+	cell->item = item;
+	__atomic_store_n(&cell->seq, pos + 1, __ATOMIC_RELEASE);
+	return 0;
+}
+
+PINK_GCC_ATTR((nonnull(1,2)))
+int pink_queue_pop(struct pink_queue *queue, void **itemptr)
+{
+	size_t pos, seq;
+	intptr_t diff;
+	struct pink_queue_cell *cell;
+
+	pos = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
+	for (;;) {
+		cell = &queue->cells[pos & queue->mask];
+		seq = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
+		diff = (intptr_t)seq - (intptr_t)(pos + 1);
+		if (diff == 0) {
+			if (__atomic_compare_exchange_n(&queue->tail, &pos, pos + 1,
+							true, __ATOMIC_RELAXED,
+							__ATOMIC_RELAXED))
+				break;
+		} else if (diff < 0) {
+			return -EAGAIN; /* empty */
+		} else {
+			pos = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
+		}
+	}
+
+	*itemptr = cell->item;
+	__atomic_store_n(&cell->seq, pos + queue->mask + 1, __ATOMIC_RELEASE);
+	return 0;
+}
+
+PINK_GCC_ATTR((nonnull(1)))
+int pink_frame_alloc(struct pink_frame **frameptr)
+{
+	int r;
+	struct pink_frame *f;
+
+	f = calloc(1, sizeof(struct pink_frame));
+	if (!f)
+		return -errno;
+	if ((r = pink_regset_alloc(&f->regset)) < 0) {
+		free(f);
+		return r;
+	}
+
+	*frameptr = f;
+	return 0;
+}
+
+void pink_frame_free(struct pink_frame *frame)
+{
+	if (!frame)
+		return;
+	pink_regset_free(frame->regset);
+	free(frame);
+}
+
+PINK_GCC_ATTR((nonnull(2,3)))
+int pink_frame_capture(pid_t pid, const struct pink_regset *regset,
+		       struct pink_frame *frame)
+{
+	int r;
+	unsigned i;
+
+	pink_regset_copy(frame->regset, regset);
+	frame->pid = pid;
+	frame->abi = regset->abi;
+	if ((r = pink_read_syscall(pid, regset, &frame->sysnum)) < 0)
+		return r;
+	for (i = 0; i < PINK_MAX_ARGS; i++) {
+		if ((r = pink_read_argument(pid, regset, i, &frame->args[i])) < 0)
+			return r;
+	}
+	frame->decision = 0;
+	return 0;
+}
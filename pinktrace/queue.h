@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2021 Ali Polatel <alip@exherbo.org>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#ifndef PINK_QUEUE_H
+#define PINK_QUEUE_H
+
+/**
+ * @file pinktrace/queue.h
+ * @brief Pink's lock-free queues for decode offloading
+ *
+ * Do not include this file directly. Use pinktrace/pink.h instead.
+ *
+ * The thread owning the ptrace(2) connection captures the system call frame
+ * with pink_frame_capture() at each stop and pushes it to a queue. Worker
+ * threads pop the frames, do the expensive decoding (reading strings, socket
+ * addresses, argument vectors) and push them back to a completion queue. The
+ * owner finally pops the completed frames, applies any writes using the frame
+ * register set and resumes the tracee.
+ *
+ * Reading tracee memory using cross memory attach works from any thread, so
+ * only the ptrace(2) requests, ie. writing registers and resuming the
+ * tracee, need to be issued by the owner thread. Note the fallback to
+ * @c PTRACE_PEEKDATA, see pink_read_vm_data(), does not work from worker
+ * threads.
+ *
+ * @defgroup pink_queue Pink's lock-free queues for decode offloading
+ * @ingroup pinktrace
+ * @{
+ **/
+
+#include <sys/types.h>
+
+/**
+ * This opaque structure represents a bounded, lock-free, multiple producer,
+ * multiple consumer queue of pointers.
+ **/
+struct pink_queue;
+
+/** Structure which represents a captured system call frame. */
+struct pink_frame {
+	/** Process ID of the stopped tracee **/
+	pid_t pid;
+
+	/** System call ABI **/
+	short abi;
+
+	/** System call number **/
+	long sysnum;
+
+	/** System call arguments **/
+	long args[PINK_MAX_ARGS];
+
+	/**
+	 * Private copy of the registry set of the tracee, which may be
+	 * passed to the reader functions from any thread and to the writer
+	 * functions from the thread owning the tracee.
+	 **/
+	struct pink_regset *regset;
+
+	/** Decision of the worker, free for use by the caller **/
+	int decision;
+
+	/** User data, free for use by the caller **/
+	void *data;
+};
+
+/**
+ * Allocate a queue
+ *
+ * @param queueptr Pointer to store the dynamically allocated queue,
+ *                 Use pink_queue_free() to free after use.
+ * @param size Number of slots, must be a power of two greater than one
+ * @return 0 on success, negated errno on failure
+ **/
+int pink_queue_alloc(struct pink_queue **queueptr, size_t size)
+	PINK_GCC_ATTR((nonnull(1)));
+
+/**
+ * Free the memory allocated for the queue
+ *
+ * @param queue Queue
+ **/
+void pink_queue_free(struct pink_queue *queue);
+
+/**
+ * Push an item to the queue
+ *
+ * @note This function is safe to call concurrently from multiple threads.
+ *
+ * @param queue Queue
+ * @param item Item
+ * @return 0 on success, -EAGAIN if the queue is full
+ **/
+int pink_queue_push(struct pink_queue *queue, void *item)
+	PINK_GCC_ATTR((nonnull(1)));
+
+/**
+ * Pop an item from the queue
+ *
+ * @note This function is safe to call concurrently from multiple threads.
+ *
+ * @param queue Queue
+ * @param itemptr Pointer to store the item
+ * @return 0 on success, -EAGAIN if the queue is empty
+ **/
+int pink_queue_pop(struct pink_queue *queue, void **itemptr)
+	PINK_GCC_ATTR((nonnull(1,2)));
+
+/**
+ * Allocate a system call frame
+ *
+ * @param frameptr Pointer to store the dynamically allocated frame,
+ *                 Use pink_frame_free() to free after use.
+ * @return 0 on success, negated errno on failure
+ **/
+int pink_frame_alloc(struct pink_frame **frameptr)
+	PINK_GCC_ATTR((nonnull(1)));
+
+/**
+ * Free the memory allocated for the system call frame
+ *
+ * @param frame System call frame
+ **/
+void pink_frame_free(struct pink_frame *frame);
+
+/**
+ * Capture the system call frame of the given tracee
+ *
+ * @note This function does not allocate memory, frames may be reused.
+ *
+ * @param pid Process ID
+ * @param regset Registry set, filled with pink_regset_fill()
+ * @param frame System call frame, must @b not be @e NULL
+ * @return 0 on success, negated errno on failure
+ **/
+int pink_frame_capture(pid_t pid, const struct pink_regset *regset,
+		       struct pink_frame *frame)
+	PINK_GCC_ATTR((nonnull(2,3)));
+
+/** @} */
+#endif
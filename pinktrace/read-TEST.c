@@ -572,6 +572,91 @@ static void test_read_string_array(void)
 			     " at argument %d failed", arg_index);
 }
 
+/*
+ * Test whether gathering the data of an iovec array works.
+ * First fork a new child, call syscall(PINK_SYSCALL_INVALID, iov, 3) with an
+ * array of three buffers and then check whether their data is gathered both
+ * fully and truncated to a shorter destination.
+ */
+static void test_read_iovec(void)
+{
+	pid_t pid;
+	struct pink_regset *regset;
+	bool it_worked = false;
+	char expstr[] = "pink floyd rocks";
+	struct iovec iov[3] = {
+		{ expstr, 5 },
+		{ expstr + 5, 6 },
+		{ expstr + 11, 5 },
+	};
+
+	pid = fork_assert();
+	if (pid == 0) {
+		trace_me_and_stop();
+		syscall(PINK_SYSCALL_INVALID, iov, 3);
+		_exit(0);
+	}
+	regset_alloc_or_kill(pid, &regset);
+
+	LOOP_WHILE_TRUE() {
+		int status;
+		ssize_t r;
+		long argval, sysnum;
+		char newstr[32];
+
+		waitpid_no_intr(pid, &status, 0);
+		if (check_exit_code_or_fail(status, 0))
+			break;
+		check_signal_or_fail(status, 0);
+		check_stopped_or_kill(pid, status);
+		if (WSTOPSIG(status) == SIGSTOP) {
+			trace_setup_or_kill(pid, test_options);
+		} else if (WSTOPSIG(status) == (SIGTRAP|0x80)) {
+			regset_fill_or_kill(pid, regset);
+			read_syscall_or_kill(pid, regset, &sysnum);
+			check_syscall_equal_or_kill(pid, sysnum, PINK_SYSCALL_INVALID);
+			read_argument_or_kill(pid, regset, 0, &argval);
+
+			memset(newstr, 0, sizeof(newstr));
+			r = pink_read_iovec(pid, regset, argval, 3,
+					    newstr, sizeof(newstr));
+			if (r != (ssize_t)strlen(expstr)) {
+				kill(pid, SIGKILL);
+				fail_verbose("pink_read_iovec = %zd (errno:%d %s)",
+					     r, r < 0 ? (int)-r : 0,
+					     r < 0 ? strerror(-r) : "");
+			}
+			check_string_equal_or_kill(pid, newstr, expstr, r);
+
+			memset(newstr, 0, sizeof(newstr));
+			r = pink_read_iovec(pid, regset, argval, 3, newstr, 7);
+			if (r != 7) {
+				kill(pid, SIGKILL);
+				fail_verbose("truncated pink_read_iovec = %zd", r);
+			}
+			check_string_equal_or_kill(pid, newstr, "pink fl", 8);
+
+			memset(newstr, 0, sizeof(newstr));
+			r = pink_read_iovec_data(pid, regset, iov + 1, 2,
+						 newstr, sizeof(newstr));
+			if (r != 11) {
+				kill(pid, SIGKILL);
+				fail_verbose("pink_read_iovec_data = %zd", r);
+			}
+			check_string_equal_or_kill(pid, newstr, "floyd rocks", 12);
+
+			it_worked = true;
+			kill(pid, SIGKILL);
+			break;
+		}
+		trace_syscall_or_kill(pid, 0);
+	}
+	pink_regset_free(regset);
+
+	if (!it_worked)
+		fail_verbose("Test for gathering iovec data failed");
+}
+
 static void test_fixture_read(void) {
 	test_fixture_start();
 
@@ -589,6 +674,7 @@ static void test_fixture_read(void) {
 		run_test(test_read_vm_data_nul_long);
 	for (_i = 0; _i < PINK_MAX_ARGS; _i++)
 		run_test(test_read_string_array);
+	run_test(test_read_iovec);
 
 	test_fixture_end();
 }
@@ -118,27 +118,8 @@ int pink_read_syscall(pid_t pid, const struct pink_regset *regset, long *sysnum)
  */
 static inline int is_negated_errno(unsigned long int val, short abi)
 {
-	size_t nerrnos;
-
-	switch (abi) {
-	case 0:
-		nerrnos = nerrnos0;
-		break;
-#if PINK_ABIS_SUPPORTED > 1
-	case 1:
-		nerrnos = nerrnos1;
-		break;
-# if PINK_ABIS_SUPPORTED > 2
-	case 2:
-		nerrnos = nerrnos2;
-		break;
-# endif
-#endif
-	default:
-		_pink_assert_not_reached();
-	}
-
-	unsigned long int max = -(long int) nerrnos;
+	/* Personalities share the errno table, see name.c */
+	unsigned long int max = -(long int) nerrnos0;
 #if PINK_ABIS_SUPPORTED > 1 && SIZEOF_LONG > 4
 	size_t wordsize = pink_abi_wordsize(abi);
 	if (wordsize < sizeof(val)) {
@@ -440,6 +421,155 @@ int pink_read_vm_data_full(pid_t pid, const struct pink_regset *regset,
 	return 0;
 }
 
+PINK_GCC_ATTR((nonnull(2,3,4)))
+int pink_read_vm_datav(pid_t pid, const struct pink_regset *regset,
+		       const struct iovec *local, const struct iovec *remote,
+		       size_t count)
+{
+	size_t i, len = 0;
+	ssize_t r;
+
+	for (i = 0; i < count; i++)
+		len += local[i].iov_len;
+
+	errno = 0;
+	r = pink_vm_creadv(pid, regset, local, remote, count);
+	if (r < 0 && (errno == ENOSYS || errno == EPERM)) {
+		for (i = 0; i < count; i++) {
+			r = pink_vm_lread(pid, regset, (long)remote[i].iov_base,
+					  local[i].iov_base, local[i].iov_len);
+			if (r < 0)
+				return -errno;
+			if ((size_t)r != local[i].iov_len)
+				return -EFAULT;
+		}
+		return 0;
+	}
+	if (r < 0)
+		return -errno;
+	if ((size_t)r != len)
+		return -EFAULT;
+	return 0;
+}
+
+#ifndef IOV_MAX
+# define IOV_MAX 1024
+#endif
+
+/* Total length of an iovec array, capped at len */
+static size_t iovec_length(const struct iovec *iov, size_t iovcnt, size_t len)
+{
+	size_t i, total = 0;
+
+	for (i = 0; i < iovcnt && total < len; i++)
+		total += iov[i].iov_len;
+	return MIN(total, len);
+}
+
+PINK_GCC_ATTR((nonnull(2,3,5)))
+ssize_t pink_read_iovec_data(pid_t pid, const struct pink_regset *regset,
+			     const struct iovec *iov, size_t iovcnt,
+			     char *dest, size_t len)
+{
+	size_t i, total;
+	ssize_t r;
+
+	if (iovcnt > IOV_MAX)
+		return -EINVAL;
+
+	/*
+	 * The kernel stops copying when the local buffer is full, so the
+	 * array of the caller is passed as is even if its total length
+	 * exceeds len.
+	 */
+	errno = 0;
+	r = vm_cgather(pid, dest, len, iov, iovcnt);
+	if (r >= 0)
+		return r;
+	if (errno != ENOSYS && errno != EPERM)
+		return -errno;
+
+	total = iovec_length(iov, iovcnt, len);
+	for (i = 0, r = 0; i < iovcnt && (size_t)r < total; i++) {
+		ssize_t l;
+		size_t m = MIN(iov[i].iov_len, total - r);
+
+		l = pink_vm_lread(pid, regset, (long)iov[i].iov_base, dest + r, m);
+		if (l < 0)
+			return r > 0 ? r : -errno;
+		r += l;
+		if ((size_t)l != m)
+			break;
+	}
+	return r;
+}
+
+/* Number of iovec elements read with each remote read */
+#define IOVEC_BATCH	128
+
+PINK_GCC_ATTR((nonnull(2,5)))
+ssize_t pink_read_iovec(pid_t pid, const struct pink_regset *regset,
+			long addr, size_t iovcnt, char *dest, size_t len)
+{
+	int r;
+	size_t i, wsize, count_read = 0;
+	unsigned long u_addr = addr;
+	union {
+		uint32_t v32[2 * IOVEC_BATCH];
+		struct iovec v[IOVEC_BATCH];
+	} raw;
+
+	wsize = pink_abi_wordsize(regset->abi);
+	if (wsize < sizeof(u_addr))
+		u_addr &= (1ul << 8 * wsize) - 1;
+
+	while (iovcnt > 0 && count_read < len) {
+		ssize_t l;
+		size_t n = MIN(iovcnt, IOVEC_BATCH);
+
+		if ((r = pink_read_vm_data_full(pid, regset, u_addr,
+						(char *)&raw, n * 2 * wsize)) < 0)
+			return count_read > 0 ? (ssize_t)count_read : r;
+
+		/* Expand 32-bit elements in place, last one first. */
+		if (wsize != sizeof(void *)) {
+			for (i = n; i-- > 0;) {
+				uint32_t base = raw.v32[2 * i];
+				uint32_t blen = raw.v32[2 * i + 1];
+				raw.v[i].iov_base = (void *)(unsigned long)base;
+				raw.v[i].iov_len = blen;
+			}
+		}
+
+		l = pink_read_iovec_data(pid, regset, raw.v, n,
+					 dest + count_read, len - count_read);
+		if (l < 0)
+			return count_read > 0 ? (ssize_t)count_read : l;
+		count_read += l;
+		if ((size_t)l != iovec_length(raw.v, n, len - (count_read - l)))
+			break; /* partial read */
+
+		u_addr += n * 2 * wsize;
+		iovcnt -= n;
+	}
+
+	return count_read;
+}
+
+#define ARENA_ALIGN	(2 * sizeof(void *))
+
+PINK_GCC_ATTR((nonnull(1)))
+void *pink_arena_alloc(struct pink_arena *arena, size_t size)
+{
+	size_t used;
+
+	used = (arena->used + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+	if (used > arena->size || size > arena->size - used)
+		return NULL;
+	arena->used = used + size;
+	return arena->base + used;
+}
+
 PINK_GCC_ATTR((nonnull(2,4)))
 ssize_t pink_read_vm_data_nul(pid_t pid, const struct pink_regset *regset,
 			      long addr, char *dest, size_t len)
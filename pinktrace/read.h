@@ -29,6 +29,7 @@
 
 #include <stdbool.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 
 /**
  * Read a word at the given offset in tracee's USER area and place it in res,
@@ -142,6 +143,97 @@ int pink_read_vm_data_full(pid_t pid, const struct pink_regset *regset,
 			   long addr, char *dest, size_t len)
 	PINK_GCC_ATTR((nonnull(2,4)));
 
+/**
+ * Read the given remote buffers of tracee to the given local buffers
+ *
+ * @note This function uses pink_vm_creadv() to read all buffers at once and
+ *       falls back to reading them one by one with pink_vm_lread() if cross
+ *       memory attach is not available.
+ * @see pink_vm_creadv()
+ * @see pink_vm_lread()
+ *
+ * @param pid Process ID
+ * @param regset Registry set
+ * @param local Local buffers
+ * @param remote Remote buffers, the lengths must match the local buffers
+ * @param count Number of buffers
+ * @return 0 on success, negated errno on failure and -EFAULT on partial reads
+ **/
+int pink_read_vm_datav(pid_t pid, const struct pink_regset *regset,
+		       const struct iovec *local, const struct iovec *remote,
+		       size_t count)
+	PINK_GCC_ATTR((nonnull(2,3,4)));
+
+/**
+ * Gather the data of the given iovec array of tracee into dest, as
+ * @e readv(2) would scatter it
+ *
+ * @note The iovec array, eg. pink_msghdr.iov, is passed as the remote
+ *       buffers of a single @e process_vm_readv(2) call, which falls back
+ *       to reading the buffers one by one with pink_vm_lread() if cross
+ *       memory attach is not available.
+ *
+ * @param pid Process ID
+ * @param regset Registry set
+ * @param iov Array of buffers in tracee's address space
+ * @param iovcnt Number of elements of the array, at most @c IOV_MAX
+ * @param dest Pointer to store the data, must @b not be @e NULL
+ * @param len Length of dest, data beyond it is not read
+ * @return On success, this function returns the number of bytes read.
+ *         On failure, negated errno is returned.
+ *         Check the return value for partial reads.
+ **/
+ssize_t pink_read_iovec_data(pid_t pid, const struct pink_regset *regset,
+			     const struct iovec *iov, size_t iovcnt,
+			     char *dest, size_t len)
+	PINK_GCC_ATTR((nonnull(2,3,5)));
+
+/**
+ * Read the iovec array at the given address of tracee and gather its data
+ * into dest, eg. the payload of @e writev(2)
+ *
+ * @note The iovec array is read in batches of 128 elements, each of which
+ *       is converted from the layout of the ABI of the tracee and gathered
+ *       with pink_read_iovec_data().
+ *
+ * @param pid Process ID
+ * @param regset Registry set
+ * @param addr Address of the iovec array in tracee's address space
+ * @param iovcnt Number of elements of the array
+ * @param dest Pointer to store the data, must @b not be @e NULL
+ * @param len Length of dest, data beyond it is not read
+ * @return Same as pink_read_iovec_data()
+ **/
+ssize_t pink_read_iovec(pid_t pid, const struct pink_regset *regset,
+			long addr, size_t iovcnt, char *dest, size_t len)
+	PINK_GCC_ATTR((nonnull(2,5)));
+
+/**
+ * Structure which represents a caller owned memory arena. Decoders which
+ * return variable length data, like pink_read_msghdr(), allocate it from the
+ * arena rather than the heap. Reset @e used to zero to reuse the arena.
+ **/
+struct pink_arena {
+	/** Start of the memory, should be aligned like malloc(3) memory **/
+	char *base;
+
+	/** Size of the memory in bytes **/
+	size_t size;
+
+	/** Number of bytes in use **/
+	size_t used;
+};
+
+/**
+ * Allocate memory from the arena
+ *
+ * @param arena Arena
+ * @param size Number of bytes to allocate
+ * @return Pointer aligned for any object, @e NULL if the arena is full
+ **/
+void *pink_arena_alloc(struct pink_arena *arena, size_t size)
+	PINK_GCC_ATTR((nonnull(1)));
+
 /**
  * Convenience macro to read an object
  *
@@ -30,6 +30,18 @@ void pink_regset_free(struct pink_regset *regset)
 	free(regset);
 }
 
+PINK_GCC_ATTR((nonnull(1,2)))
+void pink_regset_copy(struct pink_regset *dest, const struct pink_regset *src)
+{
+	memcpy(dest, src, sizeof(struct pink_regset));
+	/* The I/O vectors point into the registry set itself. */
+#if PINK_ARCH_AARCH64
+	dest->aarch64_io.iov_base = &dest->arm_regs_union;
+#elif PINK_ARCH_X86_64 || PINK_ARCH_X32
+	dest->x86_io.iov_base = &dest->x86_regs_union;
+#endif
+}
+
 int pink_regset_fill(pid_t pid, struct pink_regset *regset)
 {
 	int r;
@@ -39,6 +39,18 @@ int pink_regset_alloc(struct pink_regset **regptr)
  **/
 void pink_regset_free(struct pink_regset *regset);
 
+/**
+ * Copy the registry set
+ *
+ * @note The copy may be used independently of the source, eg. it may be passed
+ *       to another thread while the source is refilled.
+ *
+ * @param dest Destination registry set
+ * @param src Source registry set
+ **/
+void pink_regset_copy(struct pink_regset *dest, const struct pink_regset *src)
+	PINK_GCC_ATTR((nonnull(1,2)));
+
 /**
  * Fill the given regset structure with the registry information of the given
  * process ID
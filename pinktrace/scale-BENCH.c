@@ -0,0 +1,352 @@
+/*
+ * Copyright (c) 2021 Ali Polatel <alip@exherbo.org>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "pinktrace-bench.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+/* Loops of the mixed workload per tracee, four system calls each */
+#define SCALE_LOOPS		16
+#define SCALE_SYSCALLS		4
+#define SCALE_STACK_SIZE	(64 * 1024)
+
+static const unsigned long scale_counts[] = {
+	1, 10, 100, 1000, 10000,
+};
+
+static const int scale_options =
+	PINK_TRACE_OPTION_SYSGOOD |
+	PINK_TRACE_OPTION_FORK |
+	PINK_TRACE_OPTION_VFORK |
+	PINK_TRACE_OPTION_CLONE |
+	PINK_TRACE_OPTION_EXITKILL;
+
+/*
+ * Latencies of the getppid(2) calls of the tracees, measured by the tracees
+ * themselves, so they include the time each stop waits for the tracer.
+ * Shared with the forked tracees.
+ */
+static uint64_t *scale_samples;
+static int scale_start[2];
+
+/*
+ * Per tracee state of the tracer, a real tracer keeps at least this much,
+ * in an open addressing table keyed by thread ID.
+ */
+struct scale_tracee {
+	pid_t tid;
+	struct pink_regset *regset;
+};
+
+struct scale_table {
+	struct scale_tracee *entries;
+	size_t size;
+	size_t count;
+};
+
+static struct scale_tracee *scale_lookup(struct scale_table *table, pid_t tid,
+					 bool insert)
+{
+	size_t i, mask = table->size - 1;
+	struct scale_tracee *deleted = NULL;
+
+	for (i = (size_t)tid * 2654435761u & mask;; i = (i + 1) & mask) {
+		struct scale_tracee *t = &table->entries[i];
+
+		if (t->tid == tid)
+			return t;
+		if (t->tid == -1 && !deleted)
+			deleted = t;
+		if (t->tid == 0) {
+			if (!insert)
+				return NULL;
+			if (deleted)
+				t = deleted;
+			if (pink_regset_alloc(&t->regset) < 0)
+				return NULL;
+			t->tid = tid;
+			table->count++;
+			return t;
+		}
+	}
+}
+
+static void scale_remove(struct scale_table *table, pid_t tid)
+{
+	struct scale_tracee *t = scale_lookup(table, tid, false);
+
+	if (!t)
+		return;
+	pink_regset_free(t->regset);
+	t->regset = NULL;
+	t->tid = -1;
+	table->count--;
+}
+
+/* Resident set size of this process in kilobytes */
+static uint64_t scale_rss(void)
+{
+	char line[128];
+	unsigned long long rss = 0;
+	FILE *f;
+
+	if (!(f = fopen("/proc/self/status", "r")))
+		return 0;
+	while (fgets(line, sizeof(line), f)) {
+		if (sscanf(line, "VmRSS: %llu kB", &rss) == 1)
+			break;
+	}
+	fclose(f);
+	return rss;
+}
+
+/* Wait for the start signal, then run the mixed workload */
+static void scale_workload(unsigned long index)
+{
+	int fd;
+	char c;
+	unsigned i;
+	uint64_t t;
+
+	while (read(scale_start[0], &c, 1) < 0 && errno == EINTR)
+		;
+	for (i = 0; i < SCALE_LOOPS; i++) {
+		t = bench_now();
+		syscall(SYS_getppid);
+		scale_samples[index * SCALE_LOOPS + i] = bench_now() - t;
+		if ((fd = open("/dev/null", O_RDWR | O_CLOEXEC)) < 0)
+			continue;
+		write(fd, &c, 1);
+		close(fd);
+	}
+}
+
+static void *scale_thread(void *arg)
+{
+	scale_workload((unsigned long)arg);
+	return NULL;
+}
+
+/*
+ * The first tracee creates half of the others as threads and half as
+ * processes, then lets them all start at once by closing the write end of
+ * the start pipe and runs the workload itself.
+ */
+static void scale_root(unsigned long n)
+{
+	int status;
+	unsigned long i, nthreads = (n - 1) / 2;
+	pid_t *pids;
+	pthread_t *threads;
+	pthread_attr_t attr;
+
+	trace_me_and_stop();
+
+	pids = calloc(n, sizeof(pid_t));
+	threads = calloc(n, sizeof(pthread_t));
+	if (!pids || !threads)
+		_exit(1);
+	pthread_attr_init(&attr);
+	pthread_attr_setstacksize(&attr, SCALE_STACK_SIZE);
+
+	for (i = 1; i < n; i++) {
+		if (i <= nthreads) {
+			if (pthread_create(&threads[i], &attr, scale_thread,
+					   (void *)i))
+				_exit(1);
+			continue;
+		}
+		if ((pids[i] = fork()) < 0)
+			_exit(1);
+		if (pids[i] == 0) {
+			close(scale_start[1]);
+			scale_workload(i);
+			_exit(0);
+		}
+	}
+	close(scale_start[1]);
+	scale_workload(0);
+
+	for (i = 1; i < n; i++) {
+		if (i <= nthreads)
+			pthread_join(threads[i], NULL);
+		else if (waitpid(pids[i], &status, 0) < 0 || status != 0)
+			_exit(1);
+	}
+	_exit(0);
+}
+
+/*
+ * Trace every tracee of the process group with PTRACE_SYSCALL, filling the
+ * registers of each system call stop.
+ */
+static bool scale_trace_loop(pid_t pid, unsigned long n,
+			     struct bench_result *result, int *exit_status)
+{
+	int r, sig, status;
+	pid_t tid;
+	long sysnum;
+	uint64_t rss_start;
+	struct scale_table table;
+	struct scale_tracee *t;
+
+	table.size = 16;
+	while (table.size < 2 * n)
+		table.size *= 2;
+	table.count = 0;
+	if (!(table.entries = calloc(table.size, sizeof(struct scale_tracee)))) {
+		fail_verbose("calloc of %zu tracees failed", table.size);
+		return false;
+	}
+	rss_start = scale_rss();
+
+	for (;;) {
+		tid = waitpid(-pid, &status, __WALL);
+		if (tid < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno != ECHILD)
+				fail_verbose("waitpid (errno:%d %s)",
+					     errno, strerror(errno));
+			break;
+		}
+		if (WIFEXITED(status) || WIFSIGNALED(status)) {
+			if (tid == pid)
+				*exit_status = status;
+			scale_remove(&table, tid);
+			continue;
+		}
+
+		result->stops++;
+		if (!(t = scale_lookup(&table, tid, true))) {
+			kill(-pid, SIGKILL);
+			fail_verbose("out of memory for %zu tracees", table.count);
+			continue;
+		}
+		if (table.count == n && !result->rss)
+			result->rss = scale_rss() - rss_start;
+
+		sig = 0;
+		if (WSTOPSIG(status) == (SIGTRAP | 0x80)) {
+			if ((r = pink_regset_fill(tid, t->regset)) < 0 ||
+			    (r = pink_read_syscall(tid, t->regset, &sysnum)) < 0)
+				debug("\tregset of %d (errno:%d %s)\n",
+				      tid, -r, strerror(-r));
+		} else if (pink_event_decide(status) == PINK_EVENT_NONE &&
+			   WSTOPSIG(status) == SIGSTOP) {
+			if (tid == pid && result->stops == 1)
+				pink_trace_setup(pid, scale_options);
+		} else if (pink_event_decide(status) == PINK_EVENT_NONE) {
+			sig = WSTOPSIG(status);
+		}
+
+		if ((r = pink_trace_syscall(tid, sig)) < 0 && r != -ESRCH)
+			debug("\tresume %d (errno:%d %s)\n", tid, -r, strerror(-r));
+	}
+
+	free(table.entries);
+	return true;
+}
+
+/*
+ * Measure the throughput of the tracer, the latency of the traced system
+ * calls and the memory of the tracer per tracee as the number of concurrent
+ * tracees grows up to $PINK_BENCH_MAX_TRACEES, by default 10000.
+ */
+static void bench_scale(void)
+{
+	int status = -1;
+	unsigned s;
+	unsigned long n, max = 10000;
+	const char *env;
+	uint64_t start, cpu;
+	size_t samples_size;
+	pid_t pid;
+	struct bench_result result;
+
+	if ((env = getenv("PINK_BENCH_MAX_TRACEES")))
+		max = strtoul(env, NULL, 10);
+
+	for (s = 0; s < ARRAY_SIZE(scale_counts); s++) {
+		n = scale_counts[s];
+		if (n > max)
+			break;
+
+		samples_size = n * SCALE_LOOPS * sizeof(uint64_t);
+		scale_samples = mmap(NULL, samples_size, PROT_READ | PROT_WRITE,
+				     MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+		if (scale_samples == MAP_FAILED) {
+			fail_verbose("mmap (errno:%d %s)", errno, strerror(errno));
+			return;
+		}
+		if (pipe(scale_start) < 0) {
+			fail_verbose("pipe (errno:%d %s)", errno, strerror(errno));
+			munmap(scale_samples, samples_size);
+			return;
+		}
+
+		pid = fork_assert();
+		if (pid == 0)
+			scale_root(n);
+		close(scale_start[0]);
+		close(scale_start[1]);
+
+		memset(&result, 0, sizeof(result));
+		start = bench_now();
+		cpu = bench_cpu_time();
+		if (!scale_trace_loop(pid, n, &result, &status)) {
+			kill(-pid, SIGKILL);
+			waitpid_no_intr(pid, &status, 0);
+			munmap(scale_samples, samples_size);
+			return;
+		}
+		result.elapsed = bench_now() - start;
+		result.cpu = bench_cpu_time() - cpu;
+
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+			fail_verbose("%lu tracees: unexpected wait status %#x",
+				     n, status);
+			munmap(scale_samples, samples_size);
+			return;
+		}
+
+		result.name = "scale_tracees";
+		result.variant = "mixed";
+		result.param = n;
+		result.count = n * SCALE_LOOPS * SCALE_SYSCALLS;
+		result.samples = scale_samples;
+		result.nsamples = n * SCALE_LOOPS;
+		bench_report(&result);
+		info("\t%lu tracees: %llu bytes of tracer memory per tracee\n",
+		     n, (unsigned long long)result.rss * 1024 / n);
+		munmap(scale_samples, samples_size);
+	}
+}
+
+static void bench_fixture_scale(void)
+{
+	test_fixture_start();
+
+	run_test(bench_scale);
+
+	test_fixture_end();
+}
+
+void bench_suite_scale(void)
+{
+	bench_fixture_scale();
+}
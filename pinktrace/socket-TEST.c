@@ -728,6 +728,245 @@ static void test_read_socket_address_af_netlink(void)
 #endif
 }
 
+/*
+ * Test whether the socketcall argument block is decoded.
+ * First fork a new child, call syscall(SYS_getppid, 0, args) with a block of
+ * arguments laid out like those of socketcall() and then check whether the
+ * file descriptor and the socket address are read correctly. This works on
+ * architectures without socketcall() too as the extra arguments are ignored.
+ */
+static void test_read_socket_address_args_block(void)
+{
+	pid_t pid;
+	struct pink_regset *regset;
+	bool it_worked = false;
+	int test_sys = _i;
+	int expfd = 23;
+	int newfd;
+	unsigned index;
+	struct sockaddr_un addr;
+	struct pink_sockaddr newaddr;
+	unsigned long args[PINK_MAX_ARGS];
+	long sys_getppid;
+
+	sys_getppid = pink_lookup_syscall("getppid", PINK_ABI_DEFAULT);
+	index = test_sys_index(test_sys);
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, "/pink/floyd");
+	memset(args, 0, sizeof(args));
+	args[0] = expfd;
+	args[index] = (unsigned long)&addr;
+	args[index + 1] = sizeof(struct sockaddr_un);
+	info("Test: test_args_block (%s)\n", test_sys_name(test_sys));
+
+	pid = fork_assert();
+	if (pid == 0) {
+		trace_me_and_stop();
+		syscall(sys_getppid, 0, args);
+		_exit(0);
+	}
+	regset_alloc_or_kill(pid, &regset);
+
+	LOOP_WHILE_TRUE() {
+		int status;
+		long sysnum;
+
+		waitpid_no_intr(pid, &status, 0);
+		if (check_exit_code_or_fail(status, 0))
+			break;
+		check_signal_or_fail(status, 0);
+		check_stopped_or_kill(pid, status);
+		if (WSTOPSIG(status) == SIGSTOP) {
+			trace_setup_or_kill(pid, test_options);
+		} else if (WSTOPSIG(status) == (SIGTRAP|0x80)) {
+			regset_fill_or_kill(pid, regset);
+			read_syscall_or_kill(pid, regset, &sysnum);
+			if (sysnum != sys_getppid) {
+				trace_syscall_or_kill(pid, 0);
+				continue;
+			}
+			read_socket_address_or_kill(pid, regset, true, index,
+						    &newfd, &newaddr);
+			if (newfd != expfd) {
+				kill(pid, SIGKILL);
+				fail_verbose("File descriptors not equal"
+					     " (expected:%d got:%d)",
+					     expfd, newfd);
+			}
+			if (newaddr.family != AF_UNIX ||
+			    newaddr.length != sizeof(struct sockaddr_un) ||
+			    strcmp(newaddr.u.sa_un.sun_path, addr.sun_path)) {
+				kill(pid, SIGKILL);
+				fail_verbose("Socket addresses not equal"
+					     " (family:%d length:%u path:%s)",
+					     newaddr.family, newaddr.length,
+					     newaddr.u.sa_un.sun_path);
+			}
+			it_worked = true;
+			kill(pid, SIGKILL);
+			break;
+		}
+		trace_syscall_or_kill(pid, 0);
+	}
+	pink_regset_free(regset);
+
+	if (!it_worked)
+		fail_verbose("Test for decoding socketcall argument block"
+			     " for %s() failed", test_sys_name(test_sys));
+}
+
+/*
+ * Test whether message headers are decoded.
+ * First fork a new child, call syscall(SYS_getppid, msgs, msg) with a vector
+ * of message headers and a single message header, and then check whether the
+ * names, the iovec arrays and the control data are read correctly.
+ */
+static void check_msghdr_equal_or_kill(pid_t pid, const struct msghdr *exp,
+				       const struct pink_msghdr *msg)
+{
+	size_t i;
+	const struct sockaddr_un *sun = exp->msg_name;
+
+	if (msg->name.family != AF_UNIX ||
+	    strcmp(msg->name.u.sa_un.sun_path, sun->sun_path)) {
+		kill(pid, SIGKILL);
+		fail_verbose("Message names not equal"
+			     " (family:%d path:%s expected:%s)",
+			     msg->name.family, msg->name.u.sa_un.sun_path,
+			     sun->sun_path);
+	}
+	if (msg->iovlen != exp->msg_iovlen) {
+		kill(pid, SIGKILL);
+		fail_verbose("Message iovec lengths not equal (expected:%zu got:%zu)",
+			     (size_t)exp->msg_iovlen, msg->iovlen);
+	}
+	for (i = 0; i < msg->iovlen; i++) {
+		if (msg->iov[i].iov_base != exp->msg_iov[i].iov_base ||
+		    msg->iov[i].iov_len != exp->msg_iov[i].iov_len) {
+			kill(pid, SIGKILL);
+			fail_verbose("Message iovec %zu not equal", i);
+		}
+	}
+	if (msg->controllen != exp->msg_controllen ||
+	    memcmp(msg->control, exp->msg_control, msg->controllen)) {
+		kill(pid, SIGKILL);
+		fail_verbose("Message control data not equal");
+	}
+}
+
+static void test_read_msghdr(void)
+{
+	pid_t pid;
+	struct pink_regset *regset;
+	bool it_worked = false;
+	unsigned i;
+	char arena_buf[1024], data[4];
+	char control[2][CMSG_SPACE(sizeof(int))];
+	struct sockaddr_un names[2];
+	struct iovec iov[2][2];
+	struct mmsghdr msgs[2];
+	struct pink_msghdr newmsgs[2], newmsg;
+	struct pink_arena arena = { arena_buf, sizeof(arena_buf), 0 };
+	long sys_getppid;
+
+	sys_getppid = pink_lookup_syscall("getppid", PINK_ABI_DEFAULT);
+	memset(msgs, 0, sizeof(msgs));
+	for (i = 0; i < 2; i++) {
+		struct cmsghdr *cmsg;
+		int fd = 42 + i;
+
+		names[i].sun_family = AF_UNIX;
+		snprintf(names[i].sun_path, sizeof(names[i].sun_path),
+			 "/pink/floyd/%u", i);
+		iov[i][0].iov_base = data;
+		iov[i][0].iov_len = i + 1;
+		iov[i][1].iov_base = data + i;
+		iov[i][1].iov_len = 2;
+
+		memset(control[i], 0, sizeof(control[i]));
+		msgs[i].msg_hdr.msg_name = &names[i];
+		msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_un);
+		msgs[i].msg_hdr.msg_iov = iov[i];
+		msgs[i].msg_hdr.msg_iovlen = 2;
+		msgs[i].msg_hdr.msg_control = control[i];
+		msgs[i].msg_hdr.msg_controllen = sizeof(control[i]);
+		cmsg = CMSG_FIRSTHDR(&msgs[i].msg_hdr);
+		cmsg->cmsg_level = SOL_SOCKET;
+		cmsg->cmsg_type = SCM_RIGHTS;
+		cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+		memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+		msgs[i].msg_len = 7 * i;
+	}
+
+	pid = fork_assert();
+	if (pid == 0) {
+		trace_me_and_stop();
+		syscall(sys_getppid, msgs, &msgs[1].msg_hdr);
+		_exit(0);
+	}
+	regset_alloc_or_kill(pid, &regset);
+
+	LOOP_WHILE_TRUE() {
+		int r, status;
+		long sysnum, addr;
+
+		waitpid_no_intr(pid, &status, 0);
+		if (check_exit_code_or_fail(status, 0))
+			break;
+		check_signal_or_fail(status, 0);
+		check_stopped_or_kill(pid, status);
+		if (WSTOPSIG(status) == SIGSTOP) {
+			trace_setup_or_kill(pid, test_options);
+		} else if (WSTOPSIG(status) == (SIGTRAP|0x80)) {
+			regset_fill_or_kill(pid, regset);
+			read_syscall_or_kill(pid, regset, &sysnum);
+			if (sysnum != sys_getppid) {
+				trace_syscall_or_kill(pid, 0);
+				continue;
+			}
+
+			read_argument_or_kill(pid, regset, 0, &addr);
+			r = pink_read_mmsghdr(pid, regset, addr, newmsgs, 2, &arena);
+			if (r < 0) {
+				kill(pid, SIGKILL);
+				fail_verbose("pink_read_mmsghdr (errno:%d %s)",
+					     -r, strerror(-r));
+			}
+			for (i = 0; i < 2; i++) {
+				check_msghdr_equal_or_kill(pid, &msgs[i].msg_hdr,
+							   &newmsgs[i]);
+				if (newmsgs[i].len != msgs[i].msg_len) {
+					kill(pid, SIGKILL);
+					fail_verbose("Message lengths not equal");
+				}
+			}
+
+			read_argument_or_kill(pid, regset, 1, &addr);
+			r = pink_read_msghdr(pid, regset, addr, &newmsg, &arena);
+			if (r < 0) {
+				kill(pid, SIGKILL);
+				fail_verbose("pink_read_msghdr (errno:%d %s)",
+					     -r, strerror(-r));
+			}
+			check_msghdr_equal_or_kill(pid, &msgs[1].msg_hdr, &newmsg);
+
+			arena.size = arena.used = 0;
+			if (pink_read_msghdr(pid, regset, addr, &newmsg, &arena) != -ENOBUFS) {
+				kill(pid, SIGKILL);
+				fail_verbose("pink_read_msghdr did not fail with full arena");
+			}
+			it_worked = true;
+			kill(pid, SIGKILL);
+			break;
+		}
+		trace_syscall_or_kill(pid, 0);
+	}
+	pink_regset_free(regset);
+
+	if (!it_worked)
+		fail_verbose("Test for decoding message headers failed");
+}
+
 static void test_fixture_socket(void) {
 	test_fixture_start();
 
@@ -743,6 +982,9 @@ static void test_fixture_socket(void) {
 		run_test(test_read_socket_address_af_inet6);
 	for (_i = TEST_SYS_BIND; _i < TEST_SYS_MAX; _i++)
 		run_test(test_read_socket_address_af_netlink);
+	for (_i = TEST_SYS_BIND; _i < TEST_SYS_MAX; _i++)
+		run_test(test_read_socket_address_args_block);
+	run_test(test_read_msghdr);
 
 	test_fixture_end();
 }
@@ -14,15 +14,47 @@
 #include <pinktrace/private.h>
 #include <pinktrace/pink.h>
 
+/*
+ * Read count words of the argument block of
+ * int socketcall(int call, unsigned long *args);
+ * starting with the word at first_index, using a single remote read.
+ */
+PINK_GCC_ATTR((nonnull(2,5)))
+static int read_socketcall_args(pid_t pid, const struct pink_regset *regset,
+				unsigned first_index, unsigned count,
+				unsigned long *argv)
+{
+	int r;
+	unsigned i;
+	size_t wsize;
+	long addr;
+	union {
+		unsigned int i[PINK_MAX_ARGS];
+		unsigned long l[PINK_MAX_ARGS];
+	} args;
+
+	if (first_index + count > PINK_MAX_ARGS)
+		return -EINVAL;
+	if ((r = pink_read_argument(pid, regset, 1, &addr)) < 0)
+		return r;
+
+	wsize = pink_abi_wordsize(regset->abi);
+	addr = (unsigned long)addr + first_index * wsize;
+	if ((r = pink_read_vm_data_full(pid, regset, addr, (char *)&args,
+					count * wsize)) < 0)
+		return r;
+
+	for (i = 0; i < count; i++)
+		argv[i] = (wsize == sizeof(int)) ? args.i[i] : args.l[i];
+	return 0;
+}
+
 PINK_GCC_ATTR((nonnull(2,5)))
 int pink_read_socket_argument(pid_t pid, const struct pink_regset *regset,
 			      bool decode_socketcall,
 			      unsigned arg_index, unsigned long *argval)
 {
 	int r;
-	size_t wsize;
-	long addr;
-	unsigned long u_addr;
 
 	if (!argval)
 		return -EINVAL;
@@ -36,29 +68,7 @@ int pink_read_socket_argument(pid_t pid, const struct pink_regset *regset,
 		return 0;
 	}
 
-	/*
-	 * Decoding the second argument of:
-	 * int socketcall(int call, unsigned long *args);
-	 */
-
-	if ((r = pink_read_argument(pid, regset, 1, &addr)) < 0)
-		return r;
-	u_addr = addr;
-	wsize = pink_abi_wordsize(regset->abi);
-	u_addr += arg_index * wsize;
-	if (wsize == sizeof(int)) {
-		unsigned int arg;
-		if ((r = pink_read_vm_object_full(pid, regset, u_addr, &arg)) < 0)
-			return r;
-		*argval = arg;
-	} else {
-		unsigned long arg;
-		if ((r = pink_read_vm_object_full(pid, regset, u_addr, &arg)) < 0)
-			return r;
-		*argval = arg;
-	}
-
-	return 0;
+	return read_socketcall_args(pid, regset, arg_index, 1, argval);
 }
 
 PINK_GCC_ATTR((nonnull(2,6)))
@@ -71,19 +81,32 @@ int pink_read_socket_address(pid_t pid, const struct pink_regset *regset,
 	unsigned long myfd;
 	unsigned long addr, addrlen;
 
-	if (fd) {
-		r = pink_read_socket_argument(pid, regset, decode_socketcall,
-					      0, &myfd);
-		if (r < 0)
+	if (decode_socketcall) {
+		/*
+		 * Read the file descriptor, the address and its length with
+		 * a single read of the socketcall argument block.
+		 */
+		unsigned long args[PINK_MAX_ARGS];
+
+		if ((r = read_socketcall_args(pid, regset, 0, arg_index + 2,
+					      args)) < 0)
+			return r;
+		myfd = args[0];
+		addr = args[arg_index];
+		addrlen = args[arg_index + 1];
+	} else {
+		if (fd && (r = pink_read_socket_argument(pid, regset, false,
+							 0, &myfd)) < 0)
+			return r;
+		if ((r = pink_read_socket_argument(pid, regset, false,
+						   arg_index, &addr)) < 0)
+			return r;
+		if ((r = pink_read_socket_argument(pid, regset, false,
+						   arg_index + 1, &addrlen)) < 0)
 			return r;
-		*fd = (int)myfd;
 	}
-	if ((r = pink_read_socket_argument(pid, regset, decode_socketcall,
-					   arg_index, &addr)) < 0)
-		return r;
-	if ((r = pink_read_socket_argument(pid, regset, decode_socketcall,
-					   arg_index + 1, &addrlen)) < 0)
-		return r;
+	if (fd)
+		*fd = (int)myfd;
 
 	if (addr == 0) {
 		sockaddr->family = -1;
@@ -103,3 +126,224 @@ int pink_read_socket_address(pid_t pid, const struct pink_regset *regset,
 
 	return 0;
 }
+
+/* Layouts of struct msghdr and struct mmsghdr of 32-bit and 64-bit ABIs */
+struct msghdr32 {
+	uint32_t name;
+	uint32_t namelen;
+	uint32_t iov;
+	uint32_t iovlen;
+	uint32_t control;
+	uint32_t controllen;
+	uint32_t flags;
+};
+
+struct mmsghdr32 {
+	struct msghdr32 hdr;
+	uint32_t len;
+};
+
+struct msghdr64 {
+	uint64_t name;
+	uint32_t namelen;
+	uint32_t pad0;
+	uint64_t iov;
+	uint64_t iovlen;
+	uint64_t control;
+	uint64_t controllen;
+	uint32_t flags;
+	uint32_t pad1;
+};
+
+struct mmsghdr64 {
+	struct msghdr64 hdr;
+	uint32_t len;
+	uint32_t pad;
+};
+
+struct iovec32 {
+	uint32_t base;
+	uint32_t len;
+};
+
+#ifndef UIO_MAXIOV
+# define UIO_MAXIOV 1024
+#endif
+
+/* Number of message headers decoded with each pair of remote reads */
+#define MSGHDR_BATCH	64
+
+union msghdr_raw {
+	struct mmsghdr32 m32[MSGHDR_BATCH];
+	struct mmsghdr64 m64[MSGHDR_BATCH];
+	char data[1];
+};
+
+/*
+ * Decode count message headers of stride bytes at addr. The headers are
+ * read in one go, then the name, the iovec array and the control data of
+ * each message are read to their final location with one vectored read.
+ */
+static int read_msghdr_batch(pid_t pid, const struct pink_regset *regset,
+			     unsigned long addr, size_t stride, bool mmsg,
+			     struct pink_msghdr *msgs, unsigned count,
+			     struct pink_arena *arena)
+{
+	int r;
+	unsigned i, n = 0;
+	bool compat;
+	union msghdr_raw raw;
+	struct iovec local[3 * MSGHDR_BATCH], remote[3 * MSGHDR_BATCH];
+
+	compat = pink_abi_wordsize(regset->abi) == sizeof(uint32_t);
+	if ((r = pink_read_vm_data_full(pid, regset, addr, raw.data,
+					count * stride)) < 0)
+		return r;
+
+	for (i = 0; i < count; i++) {
+		struct pink_msghdr *msg = &msgs[i];
+		const char *hdr = raw.data + i * stride;
+		unsigned long name, iov, control;
+		size_t namelen, iovsize;
+
+		if (compat) {
+			const struct mmsghdr32 *m = (const struct mmsghdr32 *)hdr;
+			name = m->hdr.name;
+			namelen = m->hdr.namelen;
+			iov = m->hdr.iov;
+			msg->iovlen = m->hdr.iovlen;
+			control = m->hdr.control;
+			msg->controllen = m->hdr.controllen;
+			msg->flags = m->hdr.flags;
+			msg->len = mmsg ? m->len : 0;
+		} else {
+			const struct mmsghdr64 *m = (const struct mmsghdr64 *)hdr;
+			name = m->hdr.name;
+			namelen = m->hdr.namelen;
+			iov = m->hdr.iov;
+			msg->iovlen = m->hdr.iovlen;
+			control = m->hdr.control;
+			msg->controllen = m->hdr.controllen;
+			msg->flags = m->hdr.flags;
+			msg->len = mmsg ? m->len : 0;
+		}
+		if (msg->iovlen > UIO_MAXIOV)
+			return -EMSGSIZE;
+
+		memset(&msg->name.u, 0, sizeof(msg->name.u));
+		if (name == 0 || namelen == 0) {
+			msg->name.family = -1;
+			msg->name.length = 0;
+		} else {
+			if (namelen > sizeof(msg->name.u) - 1)
+				namelen = sizeof(msg->name.u) - 1;
+			msg->name.length = namelen;
+			local[n].iov_base = msg->name.u.pad;
+			local[n].iov_len = namelen;
+			remote[n].iov_base = (void *)name;
+			remote[n++].iov_len = namelen;
+		}
+
+		/*
+		 * The arena holds the native iovec array, 32-bit arrays are
+		 * read into its second half and expanded afterwards.
+		 */
+		msg->iov = NULL;
+		if (iov != 0 && msg->iovlen > 0) {
+			iovsize = msg->iovlen * (compat ? sizeof(struct iovec32)
+							: sizeof(struct iovec));
+			msg->iov = pink_arena_alloc(arena, msg->iovlen * sizeof(struct iovec));
+			if (!msg->iov)
+				return -ENOBUFS;
+			local[n].iov_base = (char *)(msg->iov + msg->iovlen) - iovsize;
+			local[n].iov_len = iovsize;
+			remote[n].iov_base = (void *)iov;
+			remote[n++].iov_len = iovsize;
+		} else {
+			msg->iovlen = 0;
+		}
+
+		msg->control = NULL;
+		if (control != 0 && msg->controllen > 0) {
+			msg->control = pink_arena_alloc(arena, msg->controllen);
+			if (!msg->control)
+				return -ENOBUFS;
+			local[n].iov_base = msg->control;
+			local[n].iov_len = msg->controllen;
+			remote[n].iov_base = (void *)control;
+			remote[n++].iov_len = msg->controllen;
+		} else {
+			msg->controllen = 0;
+		}
+	}
+
+	if (n > 0 && (r = pink_read_vm_datav(pid, regset, local, remote, n)) < 0)
+		return r;
+
+	for (i = 0; i < count; i++) {
+		struct pink_msghdr *msg = &msgs[i];
+
+		if (msg->name.family != -1)
+			msg->name.family = msg->name.u.sa.sa_family;
+		if (compat && msg->iov) {
+			size_t j;
+			const struct iovec32 *iov32;
+
+			iov32 = (const struct iovec32 *)(msg->iov + msg->iovlen) - msg->iovlen;
+			for (j = 0; j < msg->iovlen; j++) {
+				struct iovec32 v = iov32[j];
+				msg->iov[j].iov_base = (void *)(unsigned long)v.base;
+				msg->iov[j].iov_len = v.len;
+			}
+		}
+	}
+
+	return 0;
+}
+
+static int read_msghdrs(pid_t pid, const struct pink_regset *regset,
+			long addr, bool mmsg, struct pink_msghdr *msgs,
+			unsigned vlen, struct pink_arena *arena)
+{
+	int r;
+	size_t stride;
+	unsigned long u_addr = addr;
+
+	if (pink_abi_wordsize(regset->abi) == sizeof(uint32_t)) {
+		stride = mmsg ? sizeof(struct mmsghdr32) : sizeof(struct msghdr32);
+		u_addr &= 0xffffffffUL;
+	} else {
+		stride = mmsg ? sizeof(struct mmsghdr64) : sizeof(struct msghdr64);
+	}
+
+	while (vlen > 0) {
+		unsigned count = MIN(vlen, MSGHDR_BATCH);
+
+		if ((r = read_msghdr_batch(pid, regset, u_addr, stride, mmsg,
+					   msgs, count, arena)) < 0)
+			return r;
+		u_addr += count * stride;
+		msgs += count;
+		vlen -= count;
+	}
+
+	return 0;
+}
+
+PINK_GCC_ATTR((nonnull(2,4,5)))
+int pink_read_msghdr(pid_t pid, const struct pink_regset *regset,
+		     long addr, struct pink_msghdr *msg,
+		     struct pink_arena *arena)
+{
+	return read_msghdrs(pid, regset, addr, false, msg, 1, arena);
+}
+
+PINK_GCC_ATTR((nonnull(2,4,6)))
+int pink_read_mmsghdr(pid_t pid, const struct pink_regset *regset,
+		      long addr, struct pink_msghdr *msgs, unsigned vlen,
+		      struct pink_arena *arena)
+{
+	if (vlen > UIO_MAXIOV)
+		return -EINVAL;
+	return read_msghdrs(pid, regset, addr, true, msgs, vlen, arena);
+}
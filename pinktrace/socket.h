@@ -173,5 +173,77 @@ int pink_read_socket_address(pid_t pid, const struct pink_regset *regset,
 			     struct pink_sockaddr *sockaddr)
 	PINK_GCC_ATTR((nonnull(2,6)));
 
+/** Structure which represents a decoded message header */
+struct pink_msghdr {
+	/**
+	 * Destination or source address, family is -1 if @e msg_name was
+	 * NULL or @e msg_namelen was zero
+	 **/
+	struct pink_sockaddr name;
+
+	/**
+	 * Copy of the @e msg_iov array allocated from the arena, the
+	 * @e iov_base members are addresses in tracee's address space
+	 **/
+	struct iovec *iov;
+
+	/** Number of elements of the @e iov array **/
+	size_t iovlen;
+
+	/** Copy of the control data allocated from the arena, may be NULL **/
+	void *control;
+
+	/** Length of the control data **/
+	size_t controllen;
+
+	/** Message flags **/
+	int flags;
+
+	/** Number of bytes transmitted, only set for @e struct @e mmsghdr **/
+	unsigned int len;
+};
+
+/**
+ * Read a @e struct @e msghdr, eg. the second argument of @e sendmsg(2)
+ *
+ * @note Compat 32-bit layouts are used for 32-bit ABIs.
+ * @see pink_read_mmsghdr()
+ *
+ * @param pid Process ID
+ * @param regset Registry set
+ * @param addr Address of the message header in tracee's address space
+ * @param msg Pointer to store the decoded message header
+ * @param arena Arena to allocate the iovec array and the control data from
+ * @return 0 on success, negated errno on failure, -ENOBUFS if the arena is
+ *         too small
+ **/
+int pink_read_msghdr(pid_t pid, const struct pink_regset *regset,
+		     long addr, struct pink_msghdr *msg,
+		     struct pink_arena *arena)
+	PINK_GCC_ATTR((nonnull(2,4,5)));
+
+/**
+ * Read a vector of @e struct @e mmsghdr, eg. the second argument of
+ * @e sendmmsg(2)
+ *
+ * @note The message headers are read with a single remote read, then the
+ *       addresses, the iovec arrays and the control data of all messages
+ *       with another single, vectored remote read, in batches of 64
+ *       messages.
+ *
+ * @param pid Process ID
+ * @param regset Registry set
+ * @param addr Address of the vector in tracee's address space
+ * @param msgs Array of vlen elements to store the decoded message headers
+ * @param vlen Number of message headers, at most @c UIO_MAXIOV
+ * @param arena Arena to allocate the iovec arrays and the control data from
+ * @return 0 on success, negated errno on failure, -ENOBUFS if the arena is
+ *         too small
+ **/
+int pink_read_mmsghdr(pid_t pid, const struct pink_regset *regset,
+		      long addr, struct pink_msghdr *msgs, unsigned vlen,
+		      struct pink_arena *arena)
+	PINK_GCC_ATTR((nonnull(2,4,6)));
+
 /** @} */
 #endif
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2021 Ali Polatel <alip@exherbo.org>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "pinktrace-check.h"
+
+#include <signal.h>
+#include <linux/filter.h>
+#include <linux/seccomp.h>
+
+static void spawn_or_fail(int options, const struct sock_fprog *filter,
+			  pid_t *pid, int *pidfd)
+{
+	int r;
+	char *const argv[] = { "sh", "-c", "exit 7", NULL };
+
+	r = pink_spawn("/bin/sh", argv, NULL, options, filter, pid, pidfd);
+	info("\tspawn(%#x) = %d (pid:%d pidfd:%d)\n",
+	     (unsigned)options, r, r < 0 ? -1 : *pid, r < 0 ? -1 : *pidfd);
+	if (r < 0)
+		fail_verbose("pink_spawn (errno:%d %s)", -r, strerror(-r));
+}
+
+static void spawn_wait_or_kill(pid_t pid, int pidfd, int *status)
+{
+	pid_t r;
+
+	if (pidfd >= 0)
+		r = pink_pidfd_wait(pidfd, status, 0);
+	else
+		r = waitpid_no_intr(pid, status, __WALL);
+	if (r != pid) {
+		kill(pid, SIGKILL);
+		fail_verbose("wait (pid:%u pidfd:%d returned:%d)", pid, pidfd, r);
+	}
+}
+
+/*
+ * Test whether the child is traced from the start:
+ * Spawn /bin/sh with PTRACE_O_TRACEEXEC, check the first stop is the
+ * exec event, resume the child and check the exit code.
+ */
+static void test_spawn_exec(void)
+{
+	int pidfd, status;
+	pid_t pid;
+	enum pink_event event;
+
+	spawn_or_fail(PINK_TRACE_OPTION_EXEC | PINK_TRACE_OPTION_EXITKILL,
+		      NULL, &pid, &pidfd);
+
+	spawn_wait_or_kill(pid, pidfd, &status);
+	check_stopped_or_kill(pid, status);
+	event = event_decide_and_print(status);
+	if (event != PINK_EVENT_EXEC) {
+		kill(pid, SIGKILL);
+		fail_verbose("unexpected event %d (status:%#x), expected exec event",
+			     event, (unsigned)status);
+	}
+
+	pink_trace_resume(pid, 0);
+	spawn_wait_or_kill(pid, pidfd, &status);
+	check_exit_code_or_fail(status, 7);
+	if (pidfd >= 0)
+		close(pidfd);
+}
+
+/*
+ * Test whether the seccomp filter is installed before exec:
+ * Spawn /bin/sh with a filter which returns SECCOMP_RET_TRACE for every
+ * system call and check the first stop is the seccomp event for execve.
+ */
+static void test_spawn_seccomp(void)
+{
+#if PINK_HAVE_OPTION_SECCOMP && PINK_HAVE_EVENT_SECCOMP
+	int pidfd, status;
+	pid_t pid;
+	long sysnum;
+	enum pink_event event;
+	struct pink_regset *regset;
+	struct sock_filter insns[] = {
+		BPF_STMT(BPF_RET|BPF_K, SECCOMP_RET_TRACE),
+	};
+	struct sock_fprog prog = {
+		.len = ARRAY_SIZE(insns),
+		.filter = insns,
+	};
+
+	spawn_or_fail(PINK_TRACE_OPTION_SECCOMP | PINK_TRACE_OPTION_EXITKILL,
+		      &prog, &pid, &pidfd);
+
+	spawn_wait_or_kill(pid, pidfd, &status);
+	check_stopped_or_kill(pid, status);
+	event = event_decide_and_print(status);
+	if (event != PINK_EVENT_SECCOMP) {
+		kill(pid, SIGKILL);
+		fail_verbose("unexpected event %d (status:%#x), expected seccomp event",
+			     event, (unsigned)status);
+	}
+
+	regset_alloc_or_kill(pid, &regset);
+	regset_fill_or_kill(pid, regset);
+	pink_read_syscall(pid, regset, &sysnum);
+	check_syscall_equal_or_kill(pid, sysnum,
+				    pink_lookup_syscall("execve", regset->abi));
+	pink_regset_free(regset);
+
+	kill(pid, SIGKILL);
+	spawn_wait_or_kill(pid, pidfd, &status);
+	check_signal_or_fail(status, SIGKILL);
+	if (pidfd >= 0)
+		close(pidfd);
+#else
+	message("\tPTRACE_O_TRACESECCOMP not supported, skipping test\n");
+#endif
+}
+
+static void test_fixture_spawn(void) {
+	test_fixture_start();
+
+	run_test(test_spawn_exec);
+	run_test(test_spawn_seccomp);
+
+	test_fixture_end();
+}
+
+void test_suite_spawn(void) {
+	test_fixture_spawn();
+}
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2021 Ali Polatel <alip@exherbo.org>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include <pinktrace/private.h>
+
+#include <signal.h>
+#include <sys/prctl.h>
+#include <linux/filter.h>
+
+#include <pinktrace/pink.h>
+
+#ifndef CLONE_PIDFD
+# define CLONE_PIDFD 0x00001000
+#endif
+#ifndef PR_SET_NO_NEW_PRIVS
+# define PR_SET_NO_NEW_PRIVS 38
+#endif
+#ifndef SECCOMP_MODE_FILTER
+# define SECCOMP_MODE_FILTER 2
+#endif
+
+extern char **environ;
+
+/* Version 0 of struct clone_args, see clone3(2) */
+struct spawn_clone_args {
+	uint64_t flags;
+	uint64_t pidfd;
+	uint64_t child_tid;
+	uint64_t parent_tid;
+	uint64_t exit_signal;
+	uint64_t stack;
+	uint64_t stack_size;
+	uint64_t tls;
+};
+
+static pid_t spawn_clone(int *pidfdptr)
+{
+	pid_t pid;
+#ifdef SYS_clone3
+	int pidfd = -1;
+	struct spawn_clone_args args;
+
+	memset(&args, 0, sizeof(struct spawn_clone_args));
+	if (pidfdptr) {
+		args.flags = CLONE_PIDFD;
+		args.pidfd = (uintptr_t)&pidfd;
+	}
+	args.exit_signal = SIGCHLD;
+
+	pid = syscall(SYS_clone3, &args, sizeof(struct spawn_clone_args));
+	if (pid >= 0) {
+		if (pid > 0 && pidfdptr)
+			*pidfdptr = pidfd;
+		return pid;
+	}
+	if (errno != ENOSYS)
+		return -errno;
+#endif
+
+	pid = fork();
+	if (pid < 0)
+		return -errno;
+	if (pid > 0 && pidfdptr) {
+		*pidfdptr = pink_pidfd_open(pid, 0);
+		if (*pidfdptr < 0)
+			*pidfdptr = -1;
+	}
+	return pid;
+}
+
+/*
+ * The child blocks reading the pipe until the parent has attached and closed
+ * the write end. It may only call async-signal-safe functions here.
+ */
+PINK_GCC_ATTR((noreturn))
+static void spawn_child(int syncfd, const char *path, char *const argv[],
+			char *const envp[], const struct sock_fprog *filter)
+{
+	char c;
+
+	while (read(syncfd, &c, 1) < 0 && errno == EINTR)
+		; /* wait for EOF */
+	close(syncfd);
+
+	if (filter) {
+		if (prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) < 0 ||
+		    prctl(PR_SET_SECCOMP, SECCOMP_MODE_FILTER, filter, 0, 0) < 0)
+			_exit(127);
+	}
+
+	execve(path, argv, envp ? envp : environ);
+	_exit(127);
+}
+
+PINK_GCC_ATTR((nonnull(1,2,6)))
+int pink_spawn(const char *path, char *const argv[], char *const envp[],
+	       int options, const struct sock_fprog *filter,
+	       pid_t *pidptr, int *pidfdptr)
+{
+#if PINK_HAVE_SEIZE
+	int r, pidfd = -1;
+	int syncfd[2];
+	pid_t pid;
+
+	if ((r = pink_pipe_init(syncfd)) < 0)
+		return r;
+
+	pid = spawn_clone(pidfdptr ? &pidfd : NULL);
+	if (pid < 0) {
+		close(syncfd[0]);
+		close(syncfd[1]);
+		return pid;
+	} else if (pid == 0) {
+		close(syncfd[1]);
+		spawn_child(syncfd[0], path, argv, envp, filter);
+	}
+	close(syncfd[0]);
+
+	if ((r = pink_trace_seize(pid, options)) < 0) {
+		kill(pid, SIGKILL);
+		close(syncfd[1]);
+		waitpid(pid, NULL, __WALL);
+		if (pidfd >= 0)
+			close(pidfd);
+		return r;
+	}
+	close(syncfd[1]); /* let the child run */
+
+	*pidptr = pid;
+	if (pidfdptr)
+		*pidfdptr = pidfd;
+	return 0;
+#else
+	return -ENOSYS;
+#endif
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2021 Ali Polatel <alip@exherbo.org>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#ifndef PINK_SPAWN_H
+#define PINK_SPAWN_H
+
+/**
+ * @file pinktrace/spawn.h
+ * @brief Pink's tracee spawn helper
+ *
+ * Do not include this file directly. Use pinktrace/pink.h instead.
+ *
+ * @defgroup pink_spawn Pink's tracee spawn helper
+ * @ingroup pinktrace
+ * @{
+ **/
+
+#include <sys/types.h>
+
+struct sock_fprog;
+
+/**
+ * Start a new traced process executing the given program
+ *
+ * The child is created with @e clone3(2) using @c CLONE_PIDFD where
+ * available, falling back to @e fork(2) and @e pidfd_open(2). The parent
+ * attaches to the child using @c PTRACE_SEIZE with the given options before
+ * the child calls @e execve(2), so the first stop the tracer sees is the
+ * @c PTRACE_EVENT_EXEC stop, if #PINK_TRACE_OPTION_EXEC is given, or the
+ * first seccomp or signal stop otherwise. Unlike the classic
+ * @c PTRACE_TRACEME followed by @c SIGSTOP, there is no initial stop to wait
+ * for and no need to call pink_trace_setup().
+ *
+ * @note If the filter is not @e NULL, the child sets the no_new_privs bit
+ *       and installs the filter right before @e execve(2), so the filter
+ *       applies to the @e execve(2) call itself.
+ * @note If @e execve(2) fails, the child exits with status 127.
+ * @see PINK_HAVE_SEIZE
+ *
+ * @param path Path of the program to execute
+ * @param argv Argument vector, terminated by a @e NULL pointer
+ * @param envp Environment, terminated by a @e NULL pointer, @e NULL to
+ *             inherit the environment of the caller
+ * @param options Bitwise OR'ed PINK_TRACE_OPTION_* flags
+ * @param filter Seccomp filter to install in the child, may be @e NULL
+ * @param pidptr Pointer to store the process ID of the child,
+ *               must @b not be @e NULL
+ * @param pidfdptr Pointer to store the PID file descriptor of the child,
+ *                 may be @e NULL. If the PID file descriptor is not
+ *                 supported, -1 is stored.
+ * @return 0 on success, negated errno on failure
+ **/
+int pink_spawn(const char *path, char *const argv[], char *const envp[],
+	       int options, const struct sock_fprog *filter,
+	       pid_t *pidptr, int *pidfdptr)
+	PINK_GCC_ATTR((nonnull(1,2,6)));
+
+/** @} */
+#endif
@@ -0,0 +1,313 @@
+/*
+ * Copyright (c) 2021 Ali Polatel <alip@exherbo.org>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include <pinktrace/private.h>
+#include <pinktrace/pink.h>
+
+#define A_FD		PINK_ARG_FD
+#define A_DIRFD		PINK_ARG_DIRFD
+#define A_PATH		PINK_ARG_PATH
+#define A_SA		PINK_ARG_SOCKADDR
+#define A_SL		PINK_ARG_SOCKLEN
+#define A_SLP		PINK_ARG_SOCKLEN_PTR
+#define A_IOV		PINK_ARG_IOVEC
+#define A_IOVCNT	PINK_ARG_IOVCNT
+#define A_MSG		PINK_ARG_MSGHDR
+#define A_FL		PINK_ARG_FLAGS
+
+#define C_F	PINK_SYSCALL_CLASS_FILE
+#define C_N	PINK_SYSCALL_CLASS_NETWORK
+#define C_P	PINK_SYSCALL_CLASS_PROCESS
+#define C_M	PINK_SYSCALL_CLASS_MEMORY
+#define C_I	PINK_SYSCALL_CLASS_IPC
+
+/*
+ * The metadata is keyed by name rather than by number so a single table
+ * serves all architectures and personalities. Names which don't occur in
+ * the syscall tables of an architecture are simply never looked up.
+ * Arguments which aren't listed are of kind PINK_ARG_OTHER.
+ */
+static const struct sysinfo_entry {
+	char name[SYSCALL_NAME_SIZE];
+	struct pink_syscall_info info;
+} sysinfo_table[] = {
+	{"_llseek",		{5, {A_FD},				C_F}},
+	{"accept",		{3, {A_FD, A_SA, A_SLP},		C_N}},
+	{"accept4",		{4, {A_FD, A_SA, A_SLP, A_FL},		C_N}},
+	{"access",		{2, {A_PATH},				C_F}},
+	{"acct",		{1, {A_PATH},				C_F}},
+	{"bind",		{3, {A_FD, A_SA, A_SL},			C_N}},
+	{"brk",			{1, {0},				C_M}},
+	{"chdir",		{1, {A_PATH},				C_F}},
+	{"chmod",		{2, {A_PATH},				C_F}},
+	{"chown",		{3, {A_PATH},				C_F}},
+	{"chown32",		{3, {A_PATH},				C_F}},
+	{"chroot",		{1, {A_PATH},				C_F}},
+	{"clone",		{5, {A_FL},				C_P}},
+	{"clone3",		{2, {0},				C_P}},
+	{"close",		{1, {A_FD},				C_F}},
+	{"close_range",		{3, {A_FD, A_FD, A_FL},			C_F}},
+	{"connect",		{3, {A_FD, A_SA, A_SL},			C_N}},
+	{"copy_file_range",	{6, {A_FD, 0, A_FD, 0, 0, A_FL},	C_F}},
+	{"creat",		{2, {A_PATH},				C_F}},
+	{"dup",			{1, {A_FD},				C_F}},
+	{"dup2",		{2, {A_FD, A_FD},			C_F}},
+	{"dup3",		{3, {A_FD, A_FD, A_FL},			C_F}},
+	{"eventfd",		{1, {0},				C_I}},
+	{"eventfd2",		{2, {0, A_FL},				C_I}},
+	{"execve",		{3, {A_PATH},				C_F|C_P}},
+	{"execveat",		{5, {A_DIRFD, A_PATH, 0, 0, A_FL},	C_F|C_P}},
+	{"exit",		{1, {0},				C_P}},
+	{"exit_group",		{1, {0},				C_P}},
+	{"faccessat",		{3, {A_DIRFD, A_PATH},			C_F}},
+	{"faccessat2",		{4, {A_DIRFD, A_PATH, 0, A_FL},		C_F}},
+	{"fallocate",		{4, {A_FD, A_FL},			C_F}},
+	{"fchdir",		{1, {A_FD},				C_F}},
+	{"fchmod",		{2, {A_FD},				C_F}},
+	{"fchmodat",		{3, {A_DIRFD, A_PATH},			C_F}},
+	{"fchown",		{3, {A_FD},				C_F}},
+	{"fchown32",		{3, {A_FD},				C_F}},
+	{"fchownat",		{5, {A_DIRFD, A_PATH, 0, 0, A_FL},	C_F}},
+	{"fcntl",		{3, {A_FD},				C_F}},
+	{"fcntl64",		{3, {A_FD},				C_F}},
+	{"fdatasync",		{1, {A_FD},				C_F}},
+	{"fgetxattr",		{4, {A_FD},				C_F}},
+	{"flistxattr",		{3, {A_FD},				C_F}},
+	{"flock",		{2, {A_FD, A_FL},			C_F}},
+	{"fork",		{0, {0},				C_P}},
+	{"fremovexattr",	{2, {A_FD},				C_F}},
+	{"fsetxattr",		{5, {A_FD, 0, 0, 0, A_FL},		C_F}},
+	{"fstat",		{2, {A_FD},				C_F}},
+	{"fstat64",		{2, {A_FD},				C_F}},
+	{"fstatat64",		{4, {A_DIRFD, A_PATH, 0, A_FL},		C_F}},
+	{"fstatfs",		{2, {A_FD},				C_F}},
+	{"fstatfs64",		{3, {A_FD},				C_F}},
+	{"fsync",		{1, {A_FD},				C_F}},
+	{"ftruncate",		{2, {A_FD},				C_F}},
+	{"ftruncate64",		{2, {A_FD},				C_F}},
+	{"futex",		{6, {0},				C_I}},
+	{"futex_time64",	{6, {0},				C_I}},
+	{"futimesat",		{3, {A_DIRFD, A_PATH},			C_F}},
+	{"getcwd",		{2, {0},				C_F}},
+	{"getdents",		{3, {A_FD},				C_F}},
+	{"getdents64",		{3, {A_FD},				C_F}},
+	{"getpeername",		{3, {A_FD, A_SA, A_SLP},		C_N}},
+	{"getpid",		{0, {0},				C_P}},
+	{"getppid",		{0, {0},				C_P}},
+	{"getsockname",		{3, {A_FD, A_SA, A_SLP},		C_N}},
+	{"getsockopt",		{5, {A_FD},				C_N}},
+	{"gettid",		{0, {0},				C_P}},
+	{"getxattr",		{4, {A_PATH},				C_F}},
+	{"inotify_add_watch",	{3, {A_FD, A_PATH, A_FL},		C_F}},
+	{"ioctl",		{3, {A_FD},				C_F}},
+	{"ipc",			{6, {0},				C_I}},
+	{"kill",		{2, {0},				C_P}},
+	{"lchown",		{3, {A_PATH},				C_F}},
+	{"lchown32",		{3, {A_PATH},				C_F}},
+	{"lgetxattr",		{4, {A_PATH},				C_F}},
+	{"link",		{2, {A_PATH, A_PATH},			C_F}},
+	{"linkat",		{5, {A_DIRFD, A_PATH, A_DIRFD, A_PATH, A_FL}, C_F}},
+	{"listen",		{2, {A_FD},				C_N}},
+	{"listxattr",		{3, {A_PATH},				C_F}},
+	{"llistxattr",		{3, {A_PATH},				C_F}},
+	{"lremovexattr",	{2, {A_PATH},				C_F}},
+	{"lseek",		{3, {A_FD},				C_F}},
+	{"lsetxattr",		{5, {A_PATH, 0, 0, 0, A_FL},		C_F}},
+	{"lstat",		{2, {A_PATH},				C_F}},
+	{"lstat64",		{2, {A_PATH},				C_F}},
+	{"madvise",		{3, {0},				C_M}},
+	{"memfd_create",	{2, {0, A_FL},				C_F|C_M}},
+	{"mkdir",		{2, {A_PATH},				C_F}},
+	{"mkdirat",		{3, {A_DIRFD, A_PATH},			C_F}},
+	{"mknod",		{3, {A_PATH},				C_F}},
+	{"mknodat",		{4, {A_DIRFD, A_PATH},			C_F}},
+	{"mlock",		{2, {0},				C_M}},
+	{"mlock2",		{3, {0, 0, A_FL},			C_M}},
+	{"mlockall",		{1, {A_FL},				C_M}},
+	{"mmap",		{6, {0, 0, 0, A_FL, A_FD},		C_M}},
+	{"mmap2",		{6, {0, 0, 0, A_FL, A_FD},		C_M}},
+	{"mount",		{5, {A_PATH, A_PATH, 0, A_FL},		C_F}},
+	{"mprotect",		{3, {0},				C_M}},
+	{"mq_open",		{4, {0, A_FL},				C_I}},
+	{"mq_timedreceive",	{5, {A_FD},				C_I}},
+	{"mq_timedsend",	{5, {A_FD},				C_I}},
+	{"mq_unlink",		{1, {0},				C_I}},
+	{"mremap",		{5, {0, 0, 0, A_FL},			C_M}},
+	{"msgctl",		{3, {0},				C_I}},
+	{"msgget",		{2, {0, A_FL},				C_I}},
+	{"msgrcv",		{5, {0, 0, 0, 0, A_FL},			C_I}},
+	{"msgsnd",		{4, {0, 0, 0, A_FL},			C_I}},
+	{"msync",		{3, {0, 0, A_FL},			C_M}},
+	{"munlock",		{2, {0},				C_M}},
+	{"munlockall",		{0, {0},				C_M}},
+	{"munmap",		{2, {0},				C_M}},
+	{"newfstatat",		{4, {A_DIRFD, A_PATH, 0, A_FL},		C_F}},
+	{"open",		{3, {A_PATH, A_FL},			C_F}},
+	{"openat",		{4, {A_DIRFD, A_PATH, A_FL},		C_F}},
+	{"openat2",		{4, {A_DIRFD, A_PATH},			C_F}},
+	{"pidfd_getfd",		{3, {A_FD, A_FD, A_FL},			C_P}},
+	{"pidfd_open",		{2, {0, A_FL},				C_P}},
+	{"pidfd_send_signal",	{4, {A_FD, 0, 0, A_FL},			C_P}},
+	{"pipe",		{1, {0},				C_I}},
+	{"pipe2",		{2, {0, A_FL},				C_I}},
+	{"prctl",		{5, {0},				C_P}},
+	{"pread",		{4, {A_FD},				C_F}},
+	{"pread64",		{4, {A_FD},				C_F}},
+	{"preadv",		{5, {A_FD, A_IOV, A_IOVCNT},		C_F}},
+	{"preadv2",		{6, {A_FD, A_IOV, A_IOVCNT, 0, 0, A_FL}, C_F}},
+	{"process_vm_readv",	{6, {0, A_IOV, A_IOVCNT, A_IOV, A_IOVCNT, A_FL}, C_P|C_M}},
+	{"process_vm_writev",	{6, {0, A_IOV, A_IOVCNT, A_IOV, A_IOVCNT, A_FL}, C_P|C_M}},
+	{"ptrace",		{4, {0},				C_P}},
+	{"pwrite",		{4, {A_FD},				C_F}},
+	{"pwrite64",		{4, {A_FD},				C_F}},
+	{"pwritev",		{5, {A_FD, A_IOV, A_IOVCNT},		C_F}},
+	{"pwritev2",		{6, {A_FD, A_IOV, A_IOVCNT, 0, 0, A_FL}, C_F}},
+	{"read",		{3, {A_FD},				C_F}},
+	{"readlink",		{3, {A_PATH},				C_F}},
+	{"readlinkat",		{4, {A_DIRFD, A_PATH},			C_F}},
+	{"readv",		{3, {A_FD, A_IOV, A_IOVCNT},		C_F}},
+	{"recv",		{4, {A_FD, 0, 0, A_FL},			C_N}},
+	{"recvfrom",		{6, {A_FD, 0, 0, A_FL, A_SA, A_SLP},	C_N}},
+	{"recvmmsg",		{5, {A_FD, 0, 0, A_FL},			C_N}},
+	{"recvmsg",		{3, {A_FD, A_MSG, A_FL},		C_N}},
+	{"removexattr",		{2, {A_PATH},				C_F}},
+	{"rename",		{2, {A_PATH, A_PATH},			C_F}},
+	{"renameat",		{4, {A_DIRFD, A_PATH, A_DIRFD, A_PATH},	C_F}},
+	{"renameat2",		{5, {A_DIRFD, A_PATH, A_DIRFD, A_PATH, A_FL}, C_F}},
+	{"rmdir",		{1, {A_PATH},				C_F}},
+	{"seccomp",		{3, {0, A_FL},				C_P}},
+	{"semctl",		{4, {0},				C_I}},
+	{"semget",		{3, {0, 0, A_FL},			C_I}},
+	{"semop",		{3, {0},				C_I}},
+	{"semtimedop",		{4, {0},				C_I}},
+	{"send",		{4, {A_FD, 0, 0, A_FL},			C_N}},
+	{"sendfile",		{4, {A_FD, A_FD},			C_F}},
+	{"sendfile64",		{4, {A_FD, A_FD},			C_F}},
+	{"sendmmsg",		{4, {A_FD, 0, 0, A_FL},			C_N}},
+	{"sendmsg",		{3, {A_FD, A_MSG, A_FL},		C_N}},
+	{"sendto",		{6, {A_FD, 0, 0, A_FL, A_SA, A_SL},	C_N}},
+	{"setns",		{2, {A_FD, A_FL},			C_P}},
+	{"setpgid",		{2, {0},				C_P}},
+	{"setsid",		{0, {0},				C_P}},
+	{"setsockopt",		{5, {A_FD},				C_N}},
+	{"setxattr",		{5, {A_PATH, 0, 0, 0, A_FL},		C_F}},
+	{"shmat",		{3, {0, 0, A_FL},			C_I|C_M}},
+	{"shmctl",		{3, {0},				C_I}},
+	{"shmdt",		{1, {0},				C_I|C_M}},
+	{"shmget",		{3, {0, 0, A_FL},			C_I}},
+	{"shutdown",		{2, {A_FD},				C_N}},
+	{"socket",		{3, {0},				C_N}},
+	{"socketcall",		{2, {0},				C_N}},
+	{"socketpair",		{4, {0},				C_N}},
+	{"splice",		{6, {A_FD, 0, A_FD, 0, 0, A_FL},	C_F}},
+	{"stat",		{2, {A_PATH},				C_F}},
+	{"stat64",		{2, {A_PATH},				C_F}},
+	{"statfs",		{2, {A_PATH},				C_F}},
+	{"statfs64",		{3, {A_PATH},				C_F}},
+	{"statx",		{5, {A_DIRFD, A_PATH, A_FL},		C_F}},
+	{"symlink",		{2, {A_PATH, A_PATH},			C_F}},
+	{"symlinkat",		{3, {A_PATH, A_DIRFD, A_PATH},		C_F}},
+	{"tee",			{4, {A_FD, A_FD, 0, A_FL},		C_F}},
+	{"tgkill",		{3, {0},				C_P}},
+	{"tkill",		{2, {0},				C_P}},
+	{"truncate",		{2, {A_PATH},				C_F}},
+	{"truncate64",		{2, {A_PATH},				C_F}},
+	{"umount2",		{2, {A_PATH, A_FL},			C_F}},
+	{"unlink",		{1, {A_PATH},				C_F}},
+	{"unlinkat",		{3, {A_DIRFD, A_PATH, A_FL},		C_F}},
+	{"unshare",		{1, {A_FL},				C_P}},
+	{"utime",		{2, {A_PATH},				C_F}},
+	{"utimensat",		{4, {A_DIRFD, A_PATH, 0, A_FL},		C_F}},
+	{"utimes",		{2, {A_PATH},				C_F}},
+	{"vfork",		{0, {0},				C_P}},
+	{"vmsplice",		{4, {A_FD, A_IOV, A_IOVCNT, A_FL},	C_F}},
+	{"wait4",		{4, {0, 0, A_FL},			C_P}},
+	{"waitid",		{5, {0, 0, 0, A_FL},			C_P}},
+	{"write",		{3, {A_FD},				C_F}},
+	{"writev",		{3, {A_FD, A_IOV, A_IOVCNT},		C_F}},
+};
+
+static struct name_index sysinfo_name_index;
+
+/*
+ * Per ABI index which maps system call table indexes to metadata table
+ * indexes plus one, zero means no metadata. Built on first use and
+ * published atomically, see name_index_lookup().
+ */
+static uint16_t *sysinfo_index[PINK_ABIS_SUPPORTED];
+
+static long sysinfo_lookup(const char *name)
+{
+	const char *hash;
+	char buf[SYSCALL_NAME_SIZE];
+
+	/* x32 marks the 64-bit variants of some system calls with "#64". */
+	if ((hash = strchr(name, '#'))) {
+		memcpy(buf, name, hash - name);
+		buf[hash - name] = '\0';
+		name = buf;
+	}
+	return name_index_lookup(&sysinfo_name_index, sysinfo_table[0].name,
+				 sizeof(struct sysinfo_entry),
+				 ARRAY_SIZE(sysinfo_table), name);
+}
+
+static uint16_t *sysinfo_index_build(short abi)
+{
+	size_t i, nsyscalls;
+	uint16_t *index;
+	const char (*sysent)[SYSCALL_NAME_SIZE];
+
+	sysent = syscall_table(abi, &nsyscalls);
+	index = calloc(nsyscalls, sizeof(uint16_t));
+	if (!index)
+		return NULL;
+	for (i = 0; i < nsyscalls; i++) {
+		long entry;
+
+		if (sysent[i][0] == '\0')
+			continue;
+		if ((entry = sysinfo_lookup(sysent[i])) >= 0)
+			index[i] = entry + 1;
+	}
+	return index;
+}
+
+const struct pink_syscall_info *pink_syscall_info(long scno, short abi)
+{
+	long entry;
+	size_t nsyscalls;
+	uint16_t *index;
+	const char (*sysent)[SYSCALL_NAME_SIZE];
+
+	if (!(sysent = syscall_table(abi, &nsyscalls)))
+		return NULL;
+	scno = syscall_index(scno);
+	if (scno < 0 || (size_t)scno >= nsyscalls)
+		return NULL;
+
+	index = __atomic_load_n(&sysinfo_index[abi], __ATOMIC_ACQUIRE);
+	if (!index) {
+		uint16_t *expected = NULL;
+
+		index = sysinfo_index_build(abi);
+		if (!index) {
+			if (sysent[scno][0] == '\0' ||
+			    (entry = sysinfo_lookup(sysent[scno])) < 0)
+				return NULL;
+			return &sysinfo_table[entry].info;
+		}
+		if (!__atomic_compare_exchange_n(&sysinfo_index[abi], &expected,
+						 index, false, __ATOMIC_ACQ_REL,
+						 __ATOMIC_ACQUIRE)) {
+			free(index);
+			index = expected;
+		}
+	}
+
+	if (index[scno] == 0)
+		return NULL;
+	return &sysinfo_table[index[scno] - 1].info;
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2021 Ali Polatel <alip@exherbo.org>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#ifndef PINK_SYSINFO_H
+#define PINK_SYSINFO_H
+
+/**
+ * @file pinktrace/sysinfo.h
+ * @brief Pink's system call metadata
+ *
+ * Do not include this file directly. Use pinktrace/pink.h instead.
+ *
+ * @defgroup pink_sysinfo Pink's system call metadata
+ * @ingroup pinktrace
+ * @{
+ **/
+
+/** Kind of a system call argument */
+enum pink_arg_kind {
+	/** Integer or pointer without a more specific kind */
+	PINK_ARG_OTHER = 0,
+	/** File descriptor */
+	PINK_ARG_FD,
+	/** Directory file descriptor, may be @c AT_FDCWD */
+	PINK_ARG_DIRFD,
+	/** Pointer to a path name */
+	PINK_ARG_PATH,
+	/** Pointer to a socket address */
+	PINK_ARG_SOCKADDR,
+	/** Length of the preceding socket address */
+	PINK_ARG_SOCKLEN,
+	/** Pointer to the length of the preceding socket address */
+	PINK_ARG_SOCKLEN_PTR,
+	/** Pointer to an array of @c struct @c iovec */
+	PINK_ARG_IOVEC,
+	/** Number of elements of the preceding @c struct @c iovec array */
+	PINK_ARG_IOVCNT,
+	/** Pointer to a @c struct @c msghdr */
+	PINK_ARG_MSGHDR,
+	/** Flags */
+	PINK_ARG_FLAGS,
+};
+
+/** System call operates on files or file descriptors */
+#define PINK_SYSCALL_CLASS_FILE		(1 << 0)
+/** System call operates on sockets */
+#define PINK_SYSCALL_CLASS_NETWORK	(1 << 1)
+/** System call creates, inspects or changes processes */
+#define PINK_SYSCALL_CLASS_PROCESS	(1 << 2)
+/** System call changes the memory map */
+#define PINK_SYSCALL_CLASS_MEMORY	(1 << 3)
+/** System call is used for inter-process communication */
+#define PINK_SYSCALL_CLASS_IPC		(1 << 4)
+
+/** Structure which represents the metadata of a system call */
+struct pink_syscall_info {
+	/** Number of arguments */
+	unsigned char nargs;
+	/** Kinds of the arguments, see enum pink_arg_kind */
+	unsigned char args[PINK_MAX_ARGS];
+	/** Bitwise OR'ed PINK_SYSCALL_CLASS_* flags */
+	unsigned short classes;
+};
+
+/**
+ * Look up the metadata of the given system call
+ *
+ * @note The first call for each ABI builds an index so that further calls
+ *       cost a single table load.
+ *
+ * @param scno System call number
+ * @param abi System call ABI
+ * @return Pointer to the metadata, @e NULL if the system call is unknown
+ *         or there is no metadata for it
+ **/
+const struct pink_syscall_info *pink_syscall_info(long scno, short abi);
+
+/** @} */
+#endif
@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) 2021 Ali Polatel <alip@exherbo.org>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "pinktrace-check.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/uio.h>
+
+#define TAP_SIZE	(64 * 1024)
+
+static void tap_alloc_or_fail(struct pink_tap **tap, int flags)
+{
+	int r;
+
+	if ((r = pink_tap_alloc(tap, -1, TAP_SIZE, flags)) < 0)
+		fail_verbose("pink_tap_alloc (errno:%d %s)", -r, strerror(-r));
+}
+
+/*
+ * Fork a child which writes to /dev/null with write and writev and reads
+ * from /dev/zero, and capture every system call stop until it exits.
+ */
+static void tap_trace(struct pink_tap *tap, int *fdptr)
+{
+	int fd[2];
+	pid_t pid;
+	bool exiting = false;
+	struct pink_regset *regset;
+
+	fd[0] = open("/dev/null", O_WRONLY|O_CLOEXEC);
+	fd[1] = open("/dev/zero", O_RDONLY|O_CLOEXEC);
+	if (fd[0] < 0 || fd[1] < 0)
+		fail_verbose("open (errno:%d %s)", errno, strerror(errno));
+
+	pid = fork_assert();
+	if (pid == 0) {
+		char buf[8];
+		struct iovec iov[2] = {
+			{ "pink ", 5 },
+			{ "floyd", 5 },
+		};
+
+		trace_me_and_stop();
+		if (write(fd[0], "hello", 5) < 0 ||
+		    writev(fd[0], iov, 2) < 0 ||
+		    read(fd[1], buf, sizeof(buf)) < 0)
+			_exit(1);
+		_exit(0);
+	}
+	regset_alloc_or_kill(pid, &regset);
+
+	LOOP_WHILE_TRUE() {
+		int r, status;
+
+		waitpid_no_intr(pid, &status, 0);
+		if (check_exit_code_or_fail(status, 0))
+			break;
+		check_signal_or_fail(status, 0);
+		check_stopped_or_kill(pid, status);
+		if (WSTOPSIG(status) == SIGSTOP) {
+			trace_setup_or_kill(pid, PINK_TRACE_OPTION_SYSGOOD);
+		} else if (WSTOPSIG(status) == (SIGTRAP|0x80)) {
+			regset_fill_or_kill(pid, regset);
+			if ((r = pink_tap_capture(tap, pid, regset, exiting)) < 0) {
+				kill(pid, SIGKILL);
+				fail_verbose("pink_tap_capture (errno:%d %s)",
+					     -r, strerror(-r));
+			}
+			exiting = !exiting;
+		}
+		trace_syscall_or_kill(pid, 0);
+	}
+
+	pink_regset_free(regset);
+	fdptr[0] = fd[0];
+	fdptr[1] = fd[1];
+}
+
+static void tap_next_or_fail(struct pink_tap *tap, int fd, int flag,
+			     const char *data, size_t len)
+{
+	const struct pink_tap_record *rec;
+
+	if (pink_tap_next(tap, &rec) < 0)
+		fail_verbose("no record, expected %zu bytes on fd %d", len, fd);
+	info("\trecord fd:%d flags:%#x len:%u orig_len:%llu\n", rec->fd,
+	     rec->flags, rec->len, (unsigned long long)rec->orig_len);
+	if (rec->fd != fd || !(rec->flags & flag) || rec->len != len ||
+	    memcmp(PINK_TAP_DATA(rec), data, len))
+		fail_verbose("unexpected record (fd:%d flags:%#x len:%u)",
+			     rec->fd, rec->flags, rec->len);
+	pink_tap_consume(tap);
+}
+
+/*
+ * Test whether write and read data is captured:
+ * Capture writes and reads of a child and check the records.
+ */
+static void test_tap_capture(void)
+{
+	int fd[2];
+	struct pink_tap *tap;
+	const struct pink_tap_record *rec;
+
+	tap_alloc_or_fail(&tap, PINK_TAP_WRITE|PINK_TAP_READ);
+	tap_trace(tap, fd);
+
+	tap_next_or_fail(tap, fd[0], PINK_TAP_WRITE, "hello", 5);
+	tap_next_or_fail(tap, fd[0], PINK_TAP_WRITE, "pink floyd", 10);
+	tap_next_or_fail(tap, fd[1], PINK_TAP_READ, "\0\0\0\0\0\0\0\0", 8);
+	if (pink_tap_next(tap, &rec) != -EAGAIN)
+		fail_verbose("unexpected record (fd:%d len:%u)", rec->fd, rec->len);
+	if (pink_tap_header(tap)->magic != PINK_TAP_MAGIC ||
+	    pink_tap_header(tap)->dropped != 0)
+		fail_verbose("unexpected tap header");
+
+	close(fd[0]);
+	close(fd[1]);
+	pink_tap_free(tap);
+}
+
+/*
+ * Test whether selection and limits are honoured:
+ * Capture writes to /dev/null only, limited to four bytes each.
+ */
+static void test_tap_select(void)
+{
+	int fd[2];
+	struct pink_tap *tap;
+	const struct pink_tap_record *rec;
+
+	tap_alloc_or_fail(&tap, PINK_TAP_WRITE|PINK_TAP_READ);
+	pink_tap_set_limit(tap, 4);
+	if (pink_tap_select_syscall(tap, "write") < 0 ||
+	    pink_tap_select_syscall(tap, "pink_floyd") != -EINVAL)
+		fail_verbose("pink_tap_select_syscall failed");
+	tap_trace(tap, fd);
+
+	tap_next_or_fail(tap, fd[0], PINK_TAP_TRUNCATED, "hell", 4);
+	if (pink_tap_next(tap, &rec) != -EAGAIN)
+		fail_verbose("unexpected record (fd:%d len:%u)", rec->fd, rec->len);
+
+	close(fd[0]);
+	close(fd[1]);
+	pink_tap_free(tap);
+}
+
+/*
+ * Test whether the ring wraps around:
+ * Capture many writes of a child to a ring of one page, consuming each
+ * record right after the system call, and check the data of every record.
+ */
+static void test_tap_wrap(void)
+{
+	int fd, r;
+	unsigned i, count = 0;
+	pid_t pid;
+	bool exiting = false;
+	char buf[200];
+	struct pink_tap *tap;
+	struct pink_regset *regset;
+	const struct pink_tap_record *rec;
+
+	if ((r = pink_tap_alloc(&tap, -1, sysconf(_SC_PAGESIZE), PINK_TAP_WRITE)) < 0)
+		fail_verbose("pink_tap_alloc (errno:%d %s)", -r, strerror(-r));
+	fd = open("/dev/null", O_WRONLY|O_CLOEXEC);
+
+	pid = fork_assert();
+	if (pid == 0) {
+		trace_me_and_stop();
+		for (i = 0; i < 64; i++) {
+			memset(buf, 'a' + i % 26, sizeof(buf));
+			if (write(fd, buf, sizeof(buf) - i) < 0)
+				_exit(1);
+		}
+		_exit(0);
+	}
+	regset_alloc_or_kill(pid, &regset);
+
+	LOOP_WHILE_TRUE() {
+		int status;
+
+		waitpid_no_intr(pid, &status, 0);
+		if (check_exit_code_or_fail(status, 0))
+			break;
+		check_signal_or_fail(status, 0);
+		check_stopped_or_kill(pid, status);
+		if (WSTOPSIG(status) == SIGSTOP) {
+			trace_setup_or_kill(pid, PINK_TRACE_OPTION_SYSGOOD);
+		} else if (WSTOPSIG(status) == (SIGTRAP|0x80)) {
+			regset_fill_or_kill(pid, regset);
+			if ((r = pink_tap_capture(tap, pid, regset, exiting)) < 0) {
+				kill(pid, SIGKILL);
+				fail_verbose("pink_tap_capture (errno:%d %s)",
+					     -r, strerror(-r));
+			}
+			exiting = !exiting;
+			while (pink_tap_next(tap, &rec) == 0) {
+				memset(buf, 'a' + count % 26, sizeof(buf));
+				if (rec->len != sizeof(buf) - count ||
+				    memcmp(PINK_TAP_DATA(rec), buf, rec->len)) {
+					kill(pid, SIGKILL);
+					fail_verbose("unexpected record %u (len:%u)",
+						     count, rec->len);
+				}
+				pink_tap_consume(tap);
+				count++;
+			}
+		}
+		trace_syscall_or_kill(pid, 0);
+	}
+
+	info("\t%u records, head:%llu\n", count,
+	     (unsigned long long)pink_tap_header(tap)->head);
+	if (count != 64 || pink_tap_header(tap)->dropped != 0)
+		fail_verbose("%u records, expected 64", count);
+
+	pink_regset_free(regset);
+	close(fd);
+	pink_tap_free(tap);
+}
+
+static void test_fixture_tap(void) {
+	test_fixture_start();
+
+	run_test(test_tap_capture);
+	run_test(test_tap_select);
+	run_test(test_tap_wrap);
+
+	test_fixture_end();
+}
+
+void test_suite_tap(void) {
+	test_fixture_tap();
+}
@@ -0,0 +1,486 @@
+/*
+ * Copyright (c) 2021 Ali Polatel <alip@exherbo.org>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include <pinktrace/private.h>
+
+#include <sys/mman.h>
+
+#include <pinktrace/pink.h>
+
+#define TAP_ALIGN(len)	(((len) + 7) & ~(size_t)7)
+
+struct pink_tap {
+	struct pink_tap_header *header;
+	char *data;
+	size_t map_size;
+	int flags;
+
+	size_t limit;
+	unsigned rate;
+	unsigned sample;
+
+	bool fd_selected;
+	uint64_t fds[PINK_TAP_MAX_FD / 64];
+
+	bool syscall_selected;
+	struct pink_dispatch *dispatch;
+};
+
+enum tap_kind {
+	TAP_BUF,	/* fd, buffer, length */
+	TAP_IOV,	/* fd, iovec array, count */
+	TAP_MSG,	/* fd, msghdr */
+};
+
+static int tap_write_buf(pid_t, struct pink_regset *, long, void *);
+static int tap_write_iov(pid_t, struct pink_regset *, long, void *);
+static int tap_write_msg(pid_t, struct pink_regset *, long, void *);
+static int tap_read_buf(pid_t, struct pink_regset *, long, void *);
+static int tap_read_iov(pid_t, struct pink_regset *, long, void *);
+static int tap_read_msg(pid_t, struct pink_regset *, long, void *);
+
+static const struct {
+	char name[SYSCALL_NAME_SIZE];
+	int flag;
+	pink_dispatch_func_t func;
+} tap_syscalls[] = {
+	{"write",	PINK_TAP_WRITE,	tap_write_buf},
+	{"pwrite",	PINK_TAP_WRITE,	tap_write_buf},
+	{"pwrite64",	PINK_TAP_WRITE,	tap_write_buf},
+	{"send",	PINK_TAP_WRITE,	tap_write_buf},
+	{"sendto",	PINK_TAP_WRITE,	tap_write_buf},
+	{"writev",	PINK_TAP_WRITE,	tap_write_iov},
+	{"pwritev",	PINK_TAP_WRITE,	tap_write_iov},
+	{"pwritev2",	PINK_TAP_WRITE,	tap_write_iov},
+	{"sendmsg",	PINK_TAP_WRITE,	tap_write_msg},
+	{"read",	PINK_TAP_READ,	tap_read_buf},
+	{"pread",	PINK_TAP_READ,	tap_read_buf},
+	{"pread64",	PINK_TAP_READ,	tap_read_buf},
+	{"recv",	PINK_TAP_READ,	tap_read_buf},
+	{"recvfrom",	PINK_TAP_READ,	tap_read_buf},
+	{"readv",	PINK_TAP_READ,	tap_read_iov},
+	{"preadv",	PINK_TAP_READ,	tap_read_iov},
+	{"preadv2",	PINK_TAP_READ,	tap_read_iov},
+	{"recvmsg",	PINK_TAP_READ,	tap_read_msg},
+};
+
+static void tap_register(struct pink_tap *tap, size_t i)
+{
+	if (tap_syscalls[i].flag == PINK_TAP_WRITE)
+		pink_dispatch_register_name(tap->dispatch, tap_syscalls[i].name,
+					    tap_syscalls[i].func, NULL, tap);
+	else
+		pink_dispatch_register_name(tap->dispatch, tap_syscalls[i].name,
+					    NULL, tap_syscalls[i].func, tap);
+}
+
+int pink_tap_alloc(struct pink_tap **tapptr, int fd, size_t size, int flags)
+{
+	int r;
+	size_t i;
+	void *map;
+	struct pink_tap *tap;
+
+	if (size <= sizeof(struct pink_tap_header) ||
+	    size % sysconf(_SC_PAGESIZE) != 0)
+		return -EINVAL;
+	if (fd >= 0 && ftruncate(fd, size) < 0)
+		return -errno;
+
+	tap = calloc(1, sizeof(struct pink_tap));
+	if (!tap)
+		return -errno;
+	if ((r = pink_dispatch_alloc(&tap->dispatch)) < 0) {
+		free(tap);
+		return r;
+	}
+
+	if (fd >= 0)
+		map = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+	else
+		map = mmap(NULL, size, PROT_READ|PROT_WRITE,
+			   MAP_SHARED|MAP_ANONYMOUS, -1, 0);
+	if (map == MAP_FAILED) {
+		r = -errno;
+		pink_dispatch_free(tap->dispatch);
+		free(tap);
+		return r;
+	}
+
+	tap->map_size = size;
+	tap->header = map;
+	tap->data = (char *)map + sizeof(struct pink_tap_header);
+	tap->flags = flags;
+	tap->header->size = (size - sizeof(struct pink_tap_header)) & ~(uint64_t)7;
+	tap->header->head = 0;
+	tap->header->tail = 0;
+	tap->header->dropped = 0;
+	tap->header->version = PINK_TAP_VERSION;
+	tap->header->magic = PINK_TAP_MAGIC;
+
+	for (i = 0; i < ARRAY_SIZE(tap_syscalls); i++)
+		if (tap_syscalls[i].flag & flags)
+			tap_register(tap, i);
+
+	*tapptr = tap;
+	return 0;
+}
+
+void pink_tap_free(struct pink_tap *tap)
+{
+	if (!tap)
+		return;
+	munmap(tap->header, tap->map_size);
+	pink_dispatch_free(tap->dispatch);
+	free(tap);
+}
+
+struct pink_tap_header *pink_tap_header(const struct pink_tap *tap)
+{
+	return tap->header;
+}
+
+void pink_tap_set_limit(struct pink_tap *tap, size_t limit)
+{
+	tap->limit = limit;
+}
+
+void pink_tap_set_sampling(struct pink_tap *tap, unsigned rate)
+{
+	tap->rate = rate;
+	tap->sample = 0;
+}
+
+int pink_tap_select_fd(struct pink_tap *tap, int fd)
+{
+	if (fd < 0 || fd >= PINK_TAP_MAX_FD)
+		return -EINVAL;
+	tap->fds[fd / 64] |= UINT64_C(1) << (fd % 64);
+	tap->fd_selected = true;
+	return 0;
+}
+
+int pink_tap_select_syscall(struct pink_tap *tap, const char *name)
+{
+	size_t i;
+	short abi;
+
+	for (i = 0; i < ARRAY_SIZE(tap_syscalls); i++)
+		if (!strcmp(tap_syscalls[i].name, name))
+			break;
+	if (i == ARRAY_SIZE(tap_syscalls) || !(tap_syscalls[i].flag & tap->flags))
+		return -EINVAL;
+
+	if (!tap->syscall_selected) {
+		size_t j;
+
+		for (j = 0; j < ARRAY_SIZE(tap_syscalls); j++) {
+			for (abi = 0; abi < PINK_ABIS_SUPPORTED; abi++) {
+				long sysnum = pink_lookup_syscall(tap_syscalls[j].name, abi);
+				if (sysnum >= 0)
+					pink_dispatch_register(tap->dispatch, abi, sysnum,
+							       NULL, NULL, NULL);
+			}
+		}
+		tap->syscall_selected = true;
+	}
+	tap_register(tap, i);
+	return 0;
+}
+
+/*
+ * Ring management: the tracer is the only producer. A record is reserved at
+ * the head, filled in place and published by advancing the head. Records
+ * never wrap, if the data doesn't fit the space available, the length is
+ * reduced and the record is marked truncated by the caller.
+ */
+static struct pink_tap_record *tap_reserve(struct pink_tap *tap, size_t *lenptr)
+{
+	uint64_t head, tail, size, offset, space, rest, avail, want;
+	const uint64_t min = TAP_ALIGN(sizeof(struct pink_tap_record) + 1);
+	struct pink_tap_header *header = tap->header;
+	struct pink_tap_record *rec;
+
+	size = header->size;
+	head = header->head;
+	tail = __atomic_load_n(&header->tail, __ATOMIC_ACQUIRE);
+
+	offset = head % size;
+	space = size - (head - tail);
+	rest = size - offset;
+	want = TAP_ALIGN(sizeof(struct pink_tap_record) + *lenptr);
+	avail = MIN(rest, space);
+
+	/* Wrap if there is more space at the start of the ring. */
+	if (avail < want && space > rest && space - rest > avail) {
+		if (rest >= sizeof(struct pink_tap_record)) {
+			rec = (struct pink_tap_record *)(tap->data + offset);
+			memset(rec, 0, sizeof(struct pink_tap_record));
+			rec->size = rest;
+			rec->flags = PINK_TAP_PAD;
+		}
+		head += rest;
+		__atomic_store_n(&header->head, head, __ATOMIC_RELEASE);
+		offset = 0;
+		avail = space - rest;
+	}
+
+	if (avail < min) {
+		__atomic_add_fetch(&header->dropped, 1, __ATOMIC_RELAXED);
+		return NULL;
+	}
+	if (avail < want)
+		*lenptr = avail - sizeof(struct pink_tap_record);
+	return (struct pink_tap_record *)(tap->data + offset);
+}
+
+static void tap_commit(struct pink_tap *tap, struct pink_tap_record *rec)
+{
+	rec->size = TAP_ALIGN(sizeof(struct pink_tap_record) + rec->len);
+	__atomic_store_n(&tap->header->head, tap->header->head + rec->size,
+			 __ATOMIC_RELEASE);
+}
+
+/* Check the file descriptor and the sampling rate */
+static bool tap_wanted(struct pink_tap *tap, long fd)
+{
+	if (tap->fd_selected &&
+	    (fd < 0 || fd >= PINK_TAP_MAX_FD ||
+	     !(tap->fds[fd / 64] & (UINT64_C(1) << (fd % 64)))))
+		return false;
+	if (tap->rate > 1 && tap->sample++ % tap->rate != 0)
+		return false;
+	return true;
+}
+
+/*
+ * Capture the data of one system call. Depending on the kind, addr is the
+ * address of the buffer, the iovec array of iovcnt elements or the message
+ * header. The length of the data is at most len bytes, orig_len is zero if
+ * it is not known in advance.
+ */
+static int tap_capture(struct pink_tap *tap, pid_t pid,
+		       struct pink_regset *regset, long sysnum,
+		       int flag, enum tap_kind kind, long addr,
+		       size_t iovcnt, size_t len, size_t orig_len)
+{
+	int r;
+	long fd;
+	ssize_t l;
+	size_t cap;
+	struct pink_tap_record *rec;
+
+	if ((r = pink_read_argument(pid, regset, 0, &fd)) < 0)
+		return r;
+	if (!tap_wanted(tap, fd))
+		return 0;
+
+	cap = len;
+	if (tap->limit && cap > tap->limit)
+		cap = tap->limit;
+	if (!(rec = tap_reserve(tap, &cap)))
+		return -ENOBUFS;
+
+	/* Read straight into the mapping. */
+	switch (kind) {
+	case TAP_BUF:
+		errno = 0;
+		l = pink_read_vm_data(pid, regset, addr, (char *)(rec + 1), cap);
+		if (l < 0)
+			l = -errno;
+		break;
+	case TAP_IOV:
+		l = pink_read_iovec(pid, regset, addr, iovcnt,
+				    (char *)(rec + 1), cap);
+		break;
+	case TAP_MSG: {
+		char buf[2048];
+		struct pink_msghdr msg;
+		struct pink_arena arena = { buf, sizeof(buf), 0 };
+
+		if ((r = pink_read_msghdr(pid, regset, addr, &msg, &arena)) < 0)
+			return r;
+		l = msg.iov ? pink_read_iovec_data(pid, regset, msg.iov,
+						   msg.iovlen, (char *)(rec + 1),
+						   cap)
+			    : 0;
+		break;
+	}
+	default:
+		abort();
+	}
+	if (l < 0)
+		return l;
+
+	rec->len = l;
+	rec->orig_len = orig_len;
+	rec->pid = pid;
+	rec->fd = fd;
+	rec->sysnum = sysnum;
+	rec->abi = regset->abi;
+	rec->flags = flag;
+	if (orig_len ? (size_t)l < orig_len : (size_t)l == cap && cap < len)
+		rec->flags |= PINK_TAP_TRUNCATED;
+	tap_commit(tap, rec);
+	return 1;
+}
+
+/* Maximum data of a record whose length isn't known in advance */
+static size_t tap_unknown_len(struct pink_tap *tap)
+{
+	return tap->limit ? tap->limit : tap->header->size;
+}
+
+static int tap_write_buf(pid_t pid, struct pink_regset *regset,
+			 long sysnum, void *data)
+{
+	int r;
+	long addr, len;
+
+	if ((r = pink_read_argument(pid, regset, 1, &addr)) < 0 ||
+	    (r = pink_read_argument(pid, regset, 2, &len)) < 0)
+		return r;
+	if (len <= 0)
+		return 0;
+	return tap_capture(data, pid, regset, sysnum, PINK_TAP_WRITE,
+			   TAP_BUF, addr, 0, len, len);
+}
+
+static int tap_write_iov(pid_t pid, struct pink_regset *regset,
+			 long sysnum, void *data)
+{
+	int r;
+	long addr, count;
+
+	if ((r = pink_read_argument(pid, regset, 1, &addr)) < 0 ||
+	    (r = pink_read_argument(pid, regset, 2, &count)) < 0)
+		return r;
+	if (count <= 0)
+		return 0;
+	return tap_capture(data, pid, regset, sysnum, PINK_TAP_WRITE,
+			   TAP_IOV, addr, count, tap_unknown_len(data), 0);
+}
+
+static int tap_write_msg(pid_t pid, struct pink_regset *regset,
+			 long sysnum, void *data)
+{
+	int r;
+	long addr;
+
+	if ((r = pink_read_argument(pid, regset, 1, &addr)) < 0)
+		return r;
+	return tap_capture(data, pid, regset, sysnum, PINK_TAP_WRITE,
+			   TAP_MSG, addr, 0, tap_unknown_len(data), 0);
+}
+
+/* Return value of a read(2) like system call at exit, zero on error */
+static long tap_retval(pid_t pid, struct pink_regset *regset)
+{
+	int err;
+	long retval;
+
+	if (pink_read_retval(pid, regset, &retval, &err) < 0 || err)
+		return 0;
+	return retval;
+}
+
+static int tap_read_buf(pid_t pid, struct pink_regset *regset,
+			long sysnum, void *data)
+{
+	int r;
+	long addr, len;
+
+	if ((len = tap_retval(pid, regset)) <= 0)
+		return 0;
+	if ((r = pink_read_argument(pid, regset, 1, &addr)) < 0)
+		return r;
+	return tap_capture(data, pid, regset, sysnum, PINK_TAP_READ,
+			   TAP_BUF, addr, 0, len, len);
+}
+
+static int tap_read_iov(pid_t pid, struct pink_regset *regset,
+			long sysnum, void *data)
+{
+	int r;
+	long addr, count, len;
+
+	if ((len = tap_retval(pid, regset)) <= 0)
+		return 0;
+	if ((r = pink_read_argument(pid, regset, 1, &addr)) < 0 ||
+	    (r = pink_read_argument(pid, regset, 2, &count)) < 0)
+		return r;
+	return tap_capture(data, pid, regset, sysnum, PINK_TAP_READ,
+			   TAP_IOV, addr, count, len, len);
+}
+
+static int tap_read_msg(pid_t pid, struct pink_regset *regset,
+			long sysnum, void *data)
+{
+	int r;
+	long addr, len;
+
+	if ((len = tap_retval(pid, regset)) <= 0)
+		return 0;
+	if ((r = pink_read_argument(pid, regset, 1, &addr)) < 0)
+		return r;
+	return tap_capture(data, pid, regset, sysnum, PINK_TAP_READ,
+			   TAP_MSG, addr, 0, len, len);
+}
+
+int pink_tap_capture(struct pink_tap *tap, pid_t pid,
+		     struct pink_regset *regset, bool exiting)
+{
+	int r;
+	long sysnum;
+
+	if ((r = pink_read_syscall(pid, regset, &sysnum)) < 0)
+		return r;
+	return pink_dispatch_call(tap->dispatch, pid, regset, regset->abi,
+				  sysnum, exiting);
+}
+
+int pink_tap_next(struct pink_tap *tap, const struct pink_tap_record **recptr)
+{
+	uint64_t head, tail, size, offset;
+	struct pink_tap_header *header = tap->header;
+	const struct pink_tap_record *rec;
+
+	size = header->size;
+	for (;;) {
+		tail = header->tail;
+		head = __atomic_load_n(&header->head, __ATOMIC_ACQUIRE);
+		if (tail == head)
+			return -EAGAIN;
+
+		offset = tail % size;
+		if (size - offset < sizeof(struct pink_tap_record)) {
+			/* Implicit padding at the end of the ring */
+			__atomic_store_n(&header->tail, tail + size - offset,
+					 __ATOMIC_RELEASE);
+			continue;
+		}
+		rec = (const struct pink_tap_record *)(tap->data + offset);
+		if (rec->flags & PINK_TAP_PAD) {
+			__atomic_store_n(&header->tail, tail + rec->size,
+					 __ATOMIC_RELEASE);
+			continue;
+		}
+		*recptr = rec;
+		return 0;
+	}
+}
+
+void pink_tap_consume(struct pink_tap *tap)
+{
+	uint64_t tail;
+	const struct pink_tap_record *rec;
+	struct pink_tap_header *header = tap->header;
+
+	tail = header->tail;
+	if (tail == __atomic_load_n(&header->head, __ATOMIC_ACQUIRE))
+		return;
+	rec = (const struct pink_tap_record *)(tap->data + tail % header->size);
+	__atomic_store_n(&header->tail, tail + rec->size, __ATOMIC_RELEASE);
+}
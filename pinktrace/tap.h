@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2021 Ali Polatel <alip@exherbo.org>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#ifndef PINK_TAP_H
+#define PINK_TAP_H
+
+/**
+ * @file pinktrace/tap.h
+ * @brief Pink's I/O payload tap
+ *
+ * Do not include this file directly. Use pinktrace/pink.h instead.
+ *
+ * A tap copies the data of write(2) like system calls at system call entry,
+ * and of read(2) like system calls at system call exit sized by the return
+ * value, into a ring of records in a shared memory mapping. The data is read
+ * from the tracee directly into the mapping with @e process_vm_readv(2), so
+ * there is no intermediate copy. The mapping may be backed by a file which
+ * another process maps and consumes using the layout documented here.
+ *
+ * The following system calls are captured, where available:
+ *  - write, pwrite, pwrite64, send, sendto at entry
+ *  - writev, pwritev, pwritev2, sendmsg at entry
+ *  - read, pread, pread64, recv, recvfrom at exit
+ *  - readv, preadv, preadv2, recvmsg at exit
+ *
+ * @note Socket calls multiplexed through @e socketcall(2) are not captured.
+ * @note On architectures which return the result in the register of the
+ *       first argument, eg. ARM, the file descriptor of system calls
+ *       captured at exit is not available.
+ *
+ * @defgroup pink_tap Pink's I/O payload tap
+ * @ingroup pinktrace
+ * @{
+ **/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/** Magic number at the start of a tap mapping, "pink" */
+#define PINK_TAP_MAGIC		0x6b6e6970
+/** Version of the layout of a tap mapping */
+#define PINK_TAP_VERSION	1
+
+/** Capture the data of write(2) like system calls */
+#define PINK_TAP_WRITE		(1 << 0)
+/** Capture the data of read(2) like system calls */
+#define PINK_TAP_READ		(1 << 1)
+/** Record is padding up to the end of the ring, skip it */
+#define PINK_TAP_PAD		(1 << 2)
+/** Data of the record was truncated */
+#define PINK_TAP_TRUNCATED	(1 << 3)
+
+/** File descriptors which may be selected with pink_tap_select_fd() */
+#define PINK_TAP_MAX_FD		1024
+
+/**
+ * Structure at the start of a tap mapping, followed by the data area
+ *
+ * Records are written at offset (head % size) of the data area and are
+ * aligned to 8 bytes. If less than a record header fits before the end of
+ * the data area, the next record starts at offset zero.
+ **/
+struct pink_tap_header {
+	/** PINK_TAP_MAGIC **/
+	uint32_t magic;
+	/** PINK_TAP_VERSION **/
+	uint32_t version;
+	/** Size of the data area in bytes **/
+	uint64_t size;
+	/** Number of bytes written, updated by the tracer **/
+	uint64_t head;
+	/** Number of bytes consumed, updated by the consumer **/
+	uint64_t tail;
+	/** Number of records dropped because the ring was full **/
+	uint64_t dropped;
+	/** Reserved **/
+	uint64_t reserved[3];
+};
+
+/** Structure which represents a record, followed by its data */
+struct pink_tap_record {
+	/** Size of the record including this header, multiple of 8 **/
+	uint32_t size;
+	/** Number of bytes of data following this header **/
+	uint32_t len;
+	/**
+	 * Number of bytes the system call requested or transferred, zero if
+	 * unknown without reading the whole iovec array
+	 **/
+	uint64_t orig_len;
+	/** Process ID **/
+	int32_t pid;
+	/** File descriptor **/
+	int32_t fd;
+	/** System call number **/
+	int32_t sysnum;
+	/** System call ABI **/
+	int16_t abi;
+	/** Bitwise OR'ed PINK_TAP_WRITE, PINK_TAP_READ, PINK_TAP_PAD, PINK_TAP_TRUNCATED **/
+	uint16_t flags;
+};
+
+/** Data of a record */
+#define PINK_TAP_DATA(rec)	((const char *)((rec) + 1))
+
+/**
+ * This opaque structure represents a tap.
+ **/
+struct pink_tap;
+
+/**
+ * Allocate a tap
+ *
+ * @param tapptr Pointer to store the dynamically allocated tap,
+ *               Use pink_tap_free() to free after use.
+ * @param fd File to map, truncated to size, -1 for an anonymous mapping
+ *           which is shared with children forked later
+ * @param size Size of the mapping including the header, a multiple of the
+ *             page size
+ * @param flags Bitwise OR'ed PINK_TAP_WRITE and PINK_TAP_READ
+ * @return 0 on success, negated errno on failure
+ **/
+int pink_tap_alloc(struct pink_tap **tapptr, int fd, size_t size, int flags)
+	PINK_GCC_ATTR((nonnull(1)));
+
+/**
+ * Unmap and free the tap
+ *
+ * @param tap Tap
+ **/
+void pink_tap_free(struct pink_tap *tap);
+
+/**
+ * Return the header of the mapping of the tap
+ *
+ * @param tap Tap
+ * @return Pointer to the header
+ **/
+struct pink_tap_header *pink_tap_header(const struct pink_tap *tap)
+	PINK_GCC_ATTR((nonnull(1)));
+
+/**
+ * Limit the number of bytes captured of each system call
+ *
+ * @param tap Tap
+ * @param limit Maximum length of the data of a record, zero for no limit
+ *              other than the size of the ring
+ **/
+void pink_tap_set_limit(struct pink_tap *tap, size_t limit)
+	PINK_GCC_ATTR((nonnull(1)));
+
+/**
+ * Capture only one of every rate matching system calls
+ *
+ * @param tap Tap
+ * @param rate Sampling rate, zero and one capture every system call
+ **/
+void pink_tap_set_sampling(struct pink_tap *tap, unsigned rate)
+	PINK_GCC_ATTR((nonnull(1)));
+
+/**
+ * Capture the given file descriptor. If no file descriptor is selected,
+ * every file descriptor is captured.
+ *
+ * @param tap Tap
+ * @param fd File descriptor, less than PINK_TAP_MAX_FD
+ * @return 0 on success, -EINVAL if the file descriptor is out of range
+ **/
+int pink_tap_select_fd(struct pink_tap *tap, int fd)
+	PINK_GCC_ATTR((nonnull(1)));
+
+/**
+ * Capture the given system call. If no system call is selected, every
+ * system call listed above is captured.
+ *
+ * @param tap Tap
+ * @param name Name of the system call, one of those listed above
+ * @return 0 on success, -EINVAL if the system call can't be captured
+ **/
+int pink_tap_select_syscall(struct pink_tap *tap, const char *name)
+	PINK_GCC_ATTR((nonnull(1,2)));
+
+/**
+ * Capture the data of the system call the tracee is stopped at
+ *
+ * @param tap Tap
+ * @param pid Process ID
+ * @param regset Registry set, filled with pink_regset_fill()
+ * @param exiting True at system call exit, false at system call entry
+ * @return 1 if a record was written, 0 if the system call was not captured,
+ *         negated errno on failure, -ENOBUFS if the ring was full
+ **/
+int pink_tap_capture(struct pink_tap *tap, pid_t pid,
+		     struct pink_regset *regset, bool exiting)
+	PINK_GCC_ATTR((nonnull(1,3)));
+
+/**
+ * Return the oldest record which was not consumed yet
+ *
+ * @note Only one thread or process may consume the records of a tap.
+ *
+ * @param tap Tap
+ * @param recptr Pointer to store the record
+ * @return 0 on success, -EAGAIN if the ring is empty
+ **/
+int pink_tap_next(struct pink_tap *tap, const struct pink_tap_record **recptr)
+	PINK_GCC_ATTR((nonnull(1,2)));
+
+/**
+ * Consume the record returned by pink_tap_next() and free its space
+ *
+ * @param tap Tap
+ **/
+void pink_tap_consume(struct pink_tap *tap)
+	PINK_GCC_ATTR((nonnull(1)));
+
+/** @} */
+#endif
@@ -0,0 +1,382 @@
+/*
+ * Copyright (c) 2021 Ali Polatel <alip@exherbo.org>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "pinktrace-bench.h"
+
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/prctl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <linux/filter.h>
+#include <linux/seccomp.h>
+
+/* Depth of the directory tree of the open workload */
+#define BENCH_PATH_DEPTH	16
+
+/*
+ * Tracing modes, compared against the untraced run of the same workload:
+ * The syscall mode stops at every system call entry and exit, the seccomp
+ * mode only at the system calls of the workload.
+ */
+enum bench_mode {
+	BENCH_UNTRACED,
+	BENCH_SYSCALL,
+	BENCH_SECCOMP,
+};
+static const char *const bench_modes[] = {
+	"untraced", "syscall", "seccomp",
+};
+
+enum bench_workload {
+	BENCH_GETPID,
+	BENCH_OPEN,
+	BENCH_EXECVE,
+	BENCH_FORK,
+};
+
+static const int bench_trace_options =
+	PINK_TRACE_OPTION_SYSGOOD |
+	PINK_TRACE_OPTION_FORK |
+	PINK_TRACE_OPTION_VFORK |
+	PINK_TRACE_OPTION_CLONE |
+	PINK_TRACE_OPTION_EXEC |
+	PINK_TRACE_OPTION_SECCOMP |
+	PINK_TRACE_OPTION_EXITKILL;
+
+static char bench_path[PATH_MAX];
+
+/* Create a file at the bottom of a directory tree, return its path */
+static const char *bench_deep_path(void)
+{
+	unsigned i;
+
+	if (bench_path[0])
+		return bench_path;
+
+	strcpy(bench_path, "/tmp/pinktrace-bench-XXXXXX");
+	if (!mkdtemp(bench_path))
+		goto fail;
+	for (i = 0; i < BENCH_PATH_DEPTH; i++) {
+		strcat(bench_path, "/d");
+		if (mkdir(bench_path, 0700) < 0)
+			goto fail;
+	}
+	strcat(bench_path, "/f");
+	if (close(open(bench_path, O_WRONLY | O_CREAT | O_CLOEXEC, 0600)) < 0)
+		goto fail;
+	return bench_path;
+fail:
+	fail_verbose("%s (errno:%d %s)", bench_path, errno, strerror(errno));
+	bench_path[0] = '\0';
+	return NULL;
+}
+
+static void bench_remove_path(void)
+{
+	char *p;
+
+	if (!bench_path[0])
+		return;
+	unlink(bench_path);
+	while ((p = strrchr(bench_path, '/')) && p != bench_path) {
+		*p = '\0';
+		if (rmdir(bench_path) < 0)
+			break;
+		if (!strncmp(bench_path, "/tmp/pinktrace-bench-", 21) &&
+		    !strchr(bench_path + 21, '/'))
+			break;
+	}
+	bench_path[0] = '\0';
+}
+
+int bench_exec_chain(const char *count)
+{
+	char next[32];
+	unsigned long n = strtoul(count, NULL, 10);
+
+	if (n == 0)
+		return EXIT_SUCCESS;
+	snprintf(next, sizeof(next), "%lu", n - 1);
+	execl("/proc/self/exe", "pinktrace-bench", BENCH_EXEC_CHAIN, next,
+	      (char *)NULL);
+	return 127;
+}
+
+/*
+ * Install a filter which returns SECCOMP_RET_TRACE for the given system
+ * calls and allows every other system call.
+ */
+static int bench_seccomp(const long *nrs, unsigned n)
+{
+	unsigned i, k = 0;
+	struct sock_filter insns[8];
+	struct sock_fprog prog;
+
+	insns[k++] = (struct sock_filter)BPF_STMT(BPF_LD | BPF_W | BPF_ABS,
+			offsetof(struct seccomp_data, nr));
+	for (i = 0; i < n; i++)
+		insns[k++] = (struct sock_filter)BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K,
+				nrs[i], n - i, 0);
+	insns[k++] = (struct sock_filter)BPF_STMT(BPF_RET | BPF_K,
+						  SECCOMP_RET_ALLOW);
+	insns[k++] = (struct sock_filter)BPF_STMT(BPF_RET | BPF_K,
+						  SECCOMP_RET_TRACE);
+	prog.len = k;
+	prog.filter = insns;
+
+	if (prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) < 0 ||
+	    prctl(PR_SET_SECCOMP, SECCOMP_MODE_FILTER, &prog) < 0)
+		return -errno;
+	return 0;
+}
+
+/* Run the workload in the child, the given number of operations */
+static void bench_workload(enum bench_workload workload, unsigned long count)
+{
+	int fd, status;
+	pid_t pid;
+	unsigned long i;
+	char arg[32];
+
+	switch (workload) {
+	case BENCH_GETPID:
+		for (i = 0; i < count; i++)
+			syscall(SYS_getpid);
+		break;
+	case BENCH_OPEN:
+		for (i = 0; i < count; i++) {
+			if ((fd = open(bench_path, O_RDONLY | O_CLOEXEC)) < 0)
+				_exit(1);
+			close(fd);
+		}
+		break;
+	case BENCH_EXECVE:
+		snprintf(arg, sizeof(arg), "%lu", count);
+		_exit(bench_exec_chain(arg));
+	case BENCH_FORK:
+		for (i = 0; i < count; i++) {
+			if ((pid = fork()) < 0)
+				_exit(1);
+			if (pid == 0)
+				_exit(0);
+			if (waitpid(pid, &status, 0) < 0 || status != 0)
+				_exit(1);
+		}
+		break;
+	default:
+		_exit(1);
+	}
+	_exit(0);
+}
+
+static unsigned bench_workload_syscalls(enum bench_workload workload,
+					long *nrs)
+{
+	unsigned n = 0;
+
+	switch (workload) {
+	case BENCH_GETPID:
+		nrs[n++] = SYS_getpid;
+		break;
+	case BENCH_OPEN:
+#ifdef SYS_open
+		nrs[n++] = SYS_open;
+#endif
+		nrs[n++] = SYS_openat;
+		nrs[n++] = SYS_close;
+		break;
+	case BENCH_EXECVE:
+		nrs[n++] = SYS_execve;
+		break;
+	case BENCH_FORK:
+		nrs[n++] = SYS_clone;
+#ifdef SYS_fork
+		nrs[n++] = SYS_fork;
+#endif
+#ifdef SYS_clone3
+		nrs[n++] = SYS_clone3;
+#endif
+		break;
+	}
+	return n;
+}
+
+/*
+ * Trace the process group of the workload until every process exits.
+ * At every system call stop, fill the registers and read the system call
+ * number, which is the least any tracer does.
+ */
+static bool bench_trace_loop(pid_t pid, enum bench_mode mode,
+			     unsigned long *stopsptr, int *exit_status)
+{
+	int r, sig, status;
+	pid_t tid;
+	long sysnum;
+	unsigned long stops = 0;
+	struct pink_regset *regset;
+	enum pink_event event;
+
+	if ((r = pink_regset_alloc(&regset)) < 0) {
+		fail_verbose("pink_regset_alloc (errno:%d %s)", -r, strerror(-r));
+		return false;
+	}
+
+	for (;;) {
+		tid = waitpid(-pid, &status, __WALL);
+		if (tid < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno == ECHILD)
+				break;
+			fail_verbose("waitpid (errno:%d %s)", errno, strerror(errno));
+			break;
+		}
+		if (WIFEXITED(status) || WIFSIGNALED(status)) {
+			if (tid == pid)
+				*exit_status = status;
+			continue;
+		}
+
+		stops++;
+		sig = 0;
+		event = pink_event_decide(status);
+		if (WSTOPSIG(status) == (SIGTRAP | 0x80) ||
+		    event == PINK_EVENT_SECCOMP) {
+			if ((r = pink_regset_fill(tid, regset)) < 0 ||
+			    (r = pink_read_syscall(tid, regset, &sysnum)) < 0)
+				debug("\tregset of %d (errno:%d %s)\n",
+				      tid, -r, strerror(-r));
+		} else if (event == PINK_EVENT_NONE &&
+			   WSTOPSIG(status) == SIGSTOP) {
+			if (tid == pid && stops == 1)
+				pink_trace_setup(pid, bench_trace_options);
+		} else if (event == PINK_EVENT_NONE) {
+			sig = WSTOPSIG(status);
+		}
+
+		if (mode == BENCH_SYSCALL)
+			r = pink_trace_syscall(tid, sig);
+		else
+			r = pink_trace_resume(tid, sig);
+		if (r < 0 && r != -ESRCH)
+			debug("\tresume %d (errno:%d %s)\n", tid, -r, strerror(-r));
+	}
+
+	pink_regset_free(regset);
+	*stopsptr = stops;
+	return true;
+}
+
+static void bench_trace(enum bench_workload workload, const char *name,
+			unsigned long count)
+{
+	int status = -1;
+	unsigned n;
+	long nrs[4];
+	pid_t pid;
+	uint64_t start, cpu, baseline = 0;
+	enum bench_mode mode;
+	struct bench_result result;
+
+	count = bench_count(count);
+	n = bench_workload_syscalls(workload, nrs);
+
+	for (mode = BENCH_UNTRACED; mode <= BENCH_SECCOMP; mode++) {
+		memset(&result, 0, sizeof(result));
+
+		pid = fork_assert();
+		if (pid == 0) {
+			/*
+			 * Install the filter after the tracer set the options,
+			 * without a tracer the traced system calls fail.
+			 */
+			if (mode != BENCH_UNTRACED)
+				trace_me_and_stop();
+			if (mode == BENCH_SECCOMP && bench_seccomp(nrs, n) < 0)
+				_exit(2);
+			bench_workload(workload, count);
+		}
+
+		start = bench_now();
+		cpu = bench_cpu_time();
+		if (mode == BENCH_UNTRACED) {
+			waitpid_no_intr(pid, &status, 0);
+		} else if (!bench_trace_loop(pid, mode, &result.stops, &status)) {
+			kill(-pid, SIGKILL);
+			waitpid_no_intr(pid, &status, 0);
+			return;
+		}
+		result.elapsed = bench_now() - start;
+		result.cpu = bench_cpu_time() - cpu;
+
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+			if (WIFEXITED(status) && WEXITSTATUS(status) == 2) {
+				info("\t%s: seccomp not supported\n", name);
+				return;
+			}
+			fail_verbose("%s %s: unexpected wait status %#x",
+				     name, bench_modes[mode], status);
+			return;
+		}
+
+		if (mode == BENCH_UNTRACED)
+			baseline = result.elapsed;
+		result.name = name;
+		result.variant = bench_modes[mode];
+		result.param = count;
+		result.count = count;
+		result.overhead = ((double)result.elapsed - baseline) / count;
+		bench_report(&result);
+	}
+}
+
+static void bench_trace_getpid(void)
+{
+	bench_trace(BENCH_GETPID, "trace_getpid", 200000);
+}
+
+static void bench_trace_open(void)
+{
+	if (!bench_deep_path())
+		return;
+	bench_trace(BENCH_OPEN, "trace_open", 50000);
+	bench_remove_path();
+}
+
+static void bench_trace_execve(void)
+{
+	bench_trace(BENCH_EXECVE, "trace_execve", 200);
+}
+
+static void bench_trace_fork(void)
+{
+	bench_trace(BENCH_FORK, "trace_fork", 2000);
+}
+
+static void bench_fixture_trace(void)
+{
+	test_fixture_start();
+
+	run_test(bench_trace_getpid);
+	run_test(bench_trace_open);
+	run_test(bench_trace_execve);
+	run_test(bench_trace_fork);
+
+	test_fixture_end();
+}
+
+void bench_suite_trace(void)
+{
+	bench_fixture_trace();
+}
@@ -17,6 +17,9 @@
 #include <signal.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <pthread.h>
+
+#define ATTACH_THREADS	8
 
 /*
  * Test whether the kernel support PTRACE_O_TRACECLONE et al options.
@@ -203,11 +206,83 @@ static void test_trace_exec(void)
 		fail_verbose("Test for PINK_TRACE_OPTION_EXEC failed");
 }
 
+static void *attach_thread(void *arg)
+{
+	for (;;)
+		pause();
+	return arg;
+}
+
+/*
+ * Test whether all threads of a running process are attached:
+ * First fork a new child which starts a few threads, attach to it using
+ * pink_attach_process() with PINK_ATTACH_INTERRUPT and check every thread
+ * reports a PTRACE_EVENT_STOP stop.
+ */
+static void test_trace_attach_process(void)
+{
+	const unsigned int test_options = PINK_TRACE_OPTION_CLONE;
+	int r, pfd[2];
+	unsigned i;
+	char c;
+	pid_t pid, tids[ATTACH_THREADS + 2];
+
+	if (pipe(pfd) < 0)
+		fail_verbose("pipe (errno:%d %s)", errno, strerror(errno));
+	pid = fork_assert();
+	if (pid == 0) {
+		pthread_t thread;
+
+		for (i = 0; i < ATTACH_THREADS; i++)
+			pthread_create(&thread, NULL, attach_thread, NULL);
+		write(pfd[1], "", 1);
+		attach_thread(NULL);
+		_exit(0);
+	}
+	if (read(pfd[0], &c, 1) != 1) {
+		kill(pid, SIGKILL);
+		fail_verbose("read (errno:%d %s)", errno, strerror(errno));
+	}
+	close(pfd[0]);
+	close(pfd[1]);
+
+	r = pink_attach_process(pid, test_options, PINK_ATTACH_INTERRUPT,
+				tids, ATTACH_THREADS + 2);
+	info("	attach_process(%u) = %d\n", pid, r);
+	if (r != ATTACH_THREADS + 1) {
+		kill(pid, SIGKILL);
+		fail_verbose("pink_attach_process attached %d threads, expected %d (errno:%d %s)",
+			     r, ATTACH_THREADS + 1, r < 0 ? -r : 0, r < 0 ? strerror(-r) : "");
+	}
+
+	for (i = 0; i < ATTACH_THREADS + 1; i++) {
+		int status;
+
+		if (waitpid_no_intr(tids[i], &status, __WALL) != tids[i]) {
+			kill(pid, SIGKILL);
+			fail_verbose("waitpid (tid:%u errno:%d %s)",
+				     tids[i], errno, strerror(errno));
+		}
+		check_stopped_or_kill(pid, status);
+		if (event_decide_and_print(status) != PINK_EVENT_STOP) {
+			kill(pid, SIGKILL);
+			fail_verbose("unexpected stop status %#x for tid:%u, expected PTRACE_EVENT_STOP",
+				     (unsigned)status, tids[i]);
+		}
+	}
+
+	/* The leader is reported last, after all the other threads are reaped. */
+	kill(pid, SIGKILL);
+	for (i = ATTACH_THREADS + 1; i-- > 0;)
+		waitpid_no_intr(tids[i], NULL, __WALL);
+}
+
 static void test_fixture_trace(void) {
 	test_fixture_start();
 	run_test(test_trace_clone);
 	run_test(test_trace_sysgood);
 	run_test(test_trace_exec);
+	run_test(test_trace_attach_process);
 	test_fixture_end();
 }
 
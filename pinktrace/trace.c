@@ -4,6 +4,9 @@
  */
 
 #include <pinktrace/private.h>
+
+#include <dirent.h>
+
 #include <pinktrace/pink.h>
 
 int pink_ptrace(int req, pid_t pid, void *addr, void *data, long *retval)
@@ -123,9 +126,12 @@ int pink_trace_get_siginfo(pid_t pid, void *info)
 #endif
 }
 
-int pink_trace_setup(pid_t pid, int options)
+/*
+ * Convert PINK_TRACE_OPTION_* flags to PTRACE_O_* flags.
+ * Shared by pink_trace_setup() and pink_trace_seize().
+ */
+int trace_options(int options, int *ptrace_optionsptr)
 {
-#if PINK_HAVE_SETUP
 	int ptrace_options;
 
 	ptrace_options = 0;
@@ -201,6 +207,17 @@ int pink_trace_setup(pid_t pid, int options)
 #endif
 	}
 
+	*ptrace_optionsptr = ptrace_options;
+	return 0;
+}
+
+int pink_trace_setup(pid_t pid, int options)
+{
+#if PINK_HAVE_SETUP
+	int r, ptrace_options;
+
+	if ((r = trace_options(options, &ptrace_options)) < 0)
+		return r;
 	return pink_ptrace(PTRACE_SETOPTIONS, pid, NULL, (void *)(long)ptrace_options, NULL);
 #else
 	return -ENOSYS;
@@ -238,7 +255,11 @@ int pink_trace_detach(pid_t pid, int sig)
 int pink_trace_seize(pid_t pid, int options)
 {
 #if PINK_HAVE_SEIZE
-	return pink_ptrace(PTRACE_SEIZE, pid, NULL, (void *)(long)options, NULL);
+	int r, ptrace_options;
+
+	if ((r = trace_options(options, &ptrace_options)) < 0)
+		return r;
+	return pink_ptrace(PTRACE_SEIZE, pid, NULL, (void *)(long)ptrace_options, NULL);
 #else
 	return -ENOSYS;
 #endif
@@ -261,3 +282,165 @@ int pink_trace_listen(pid_t pid)
 	return -ENOSYS;
 #endif
 }
+
+#if PINK_HAVE_SEIZE
+/* Thread IDs are kept sorted so lookups during rescans are cheap. */
+static size_t attach_search(const pid_t *set, size_t nr, pid_t tid)
+{
+	size_t lo = 0, hi = nr;
+
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if (set[mid] < tid)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+static int attach_insert(pid_t **setptr, size_t *nrptr, size_t *sizeptr,
+			 size_t pos, pid_t tid)
+{
+	pid_t *set = *setptr;
+
+	if (*nrptr == *sizeptr) {
+		size_t size = *sizeptr ? *sizeptr * 2 : 64;
+
+		set = realloc(set, size * sizeof(pid_t));
+		if (!set)
+			return -errno;
+		*setptr = set;
+		*sizeptr = size;
+	}
+	memmove(set + pos + 1, set + pos, (*nrptr - pos) * sizeof(pid_t));
+	set[pos] = tid;
+	(*nrptr)++;
+	return 0;
+}
+
+/*
+ * Threads created by attached threads are attached by the kernel if
+ * PTRACE_O_TRACECLONE is set, in which case PTRACE_SEIZE fails with EPERM.
+ */
+static bool attach_traced_by_us(pid_t pid, pid_t tid)
+{
+	bool r = false;
+	char path[sizeof("/proc/%u/task/%u/status") + 2 * sizeof(int) * 3];
+	char line[128];
+	FILE *f;
+
+	snprintf(path, sizeof(path), "/proc/%u/task/%u/status", pid, tid);
+	if (!(f = fopen(path, "r")))
+		return false;
+	while (fgets(line, sizeof(line), f)) {
+		if (!strncmp(line, "TracerPid:", sizeof("TracerPid:") - 1)) {
+			r = atoi(line + sizeof("TracerPid:") - 1) == getpid();
+			break;
+		}
+	}
+	fclose(f);
+	return r;
+}
+
+/*
+ * A thread which is attached with PTRACE_SEIZE must be stopped before it can
+ * be detached. Reinject the signal if the interrupt raced with one.
+ */
+static void attach_undo(const pid_t *set, size_t nr)
+{
+	size_t i;
+
+	for (i = 0; i < nr; i++) {
+		int status;
+
+		if (pink_trace_interrupt(set[i]) < 0)
+			continue;
+		if (waitpid(set[i], &status, __WALL) < 0 || !WIFSTOPPED(status))
+			continue;
+		pink_trace_detach(set[i], (status >> 16) ? 0 : WSTOPSIG(status));
+	}
+}
+#endif
+
+int pink_attach_process(pid_t pid, int options, int flags,
+			pid_t *tids, size_t count)
+{
+#if PINK_HAVE_SEIZE
+	int r;
+	bool found;
+	size_t i, nr = 0, size = 0;
+	pid_t *set = NULL;
+	char path[sizeof("/proc/%u/task") + sizeof(int) * 3];
+
+	if (pid <= 0)
+		return -EINVAL;
+#if !PINK_HAVE_INTERRUPT
+	if (flags & PINK_ATTACH_INTERRUPT)
+		return -ENOSYS;
+#endif
+
+	snprintf(path, sizeof(path), "/proc/%u/task", pid);
+	do {
+		DIR *dir;
+		struct dirent *de;
+
+		found = false;
+		if (!(dir = opendir(path))) {
+			r = errno == ENOENT ? -ESRCH : -errno;
+			goto fail;
+		}
+		while ((de = readdir(dir))) {
+			pid_t tid;
+			size_t pos;
+
+			tid = atoi(de->d_name);
+			if (tid <= 0)
+				continue;
+			pos = attach_search(set, nr, tid);
+			if (pos < nr && set[pos] == tid)
+				continue;
+
+			r = pink_trace_seize(tid, options);
+			if (r == -ESRCH)
+				continue; /* exited */
+			if (r == -EPERM && attach_traced_by_us(pid, tid))
+				r = 0;
+			if (r < 0 || (r = attach_insert(&set, &nr, &size, pos, tid)) < 0) {
+				closedir(dir);
+				goto fail;
+			}
+			found = true;
+		}
+		closedir(dir);
+	} while (found);
+
+	if (nr == 0) {
+		r = -ESRCH;
+		goto fail;
+	}
+
+#if PINK_HAVE_INTERRUPT
+	if (flags & PINK_ATTACH_INTERRUPT) {
+		for (i = 0; i < nr; i++) {
+			r = pink_trace_interrupt(set[i]);
+			if (r < 0 && r != -ESRCH)
+				goto fail;
+		}
+	}
+#endif
+
+	if (tids) {
+		for (i = 0; i < nr && i < count; i++)
+			tids[i] = set[i];
+	}
+	free(set);
+	return nr;
+fail:
+	attach_undo(set, nr);
+	free(set);
+	return r;
+#else
+	return -ENOSYS;
+#endif
+}
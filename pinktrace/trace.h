@@ -355,5 +355,42 @@ int pink_trace_interrupt(pid_t pid);
  **/
 int pink_trace_listen(pid_t pid);
 
+/**
+ * Interrupt every thread once all threads are attached
+ *
+ * @see pink_attach_process()
+ **/
+#define PINK_ATTACH_INTERRUPT	(1 << 0)
+
+/**
+ * Attach to every thread of the process specified in pid
+ *
+ * This function enumerates @e /proc/PID/task and attaches to each thread
+ * using @c PTRACE_SEIZE with the given options, repeating the enumeration
+ * until no new threads appear so threads created during the attach are not
+ * missed. Threads are not stopped while they are attached, if
+ * #PINK_ATTACH_INTERRUPT is given in flags, @c PTRACE_INTERRUPT is sent to
+ * all threads in a batch afterwards. This keeps the window in which the
+ * process is stopped as short as possible. The caller is responsible to
+ * wait for the resulting #PINK_EVENT_STOP stops.
+ *
+ * @note Give #PINK_TRACE_OPTION_CLONE in options so threads created by
+ *       attached threads are attached by the kernel.
+ * @note On failure, threads which are already attached are detached.
+ * @see PINK_HAVE_SEIZE
+ * @see PINK_HAVE_INTERRUPT
+ *
+ * @param pid Process ID
+ * @param options Bitwise OR'ed PINK_TRACE_OPTION_* flags
+ * @param flags Bitwise OR'ed PINK_ATTACH_* flags
+ * @param tids Array to store the thread IDs of the attached threads,
+ *             may be @e NULL
+ * @param count Number of elements of the array
+ * @return Number of threads attached, which may be greater than count, on
+ *         success, negated errno on failure
+ **/
+int pink_attach_process(pid_t pid, int options, int flags,
+			pid_t *tids, size_t count);
+
 /** @} */
 #endif
@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2021 Ali Polatel <alip@exherbo.org>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "pinktrace-check.h"
+
+#include <signal.h>
+
+#define URING_CHILDREN	4
+
+static const unsigned int test_options = PINK_TRACE_OPTION_SYSGOOD;
+
+static bool uring_alloc_or_skip(struct pink_uring **ringptr, unsigned entries)
+{
+	int r;
+
+	r = pink_uring_alloc(ringptr, entries);
+	if (r == -ENOSYS || r == -EPERM) {
+		message("\tio_uring not supported, skipping test\n");
+		return false;
+	} else if (r < 0) {
+		fail_verbose("pink_uring_alloc (entries:%u errno:%d %s)",
+			     entries, -r, strerror(-r));
+		return false;
+	}
+	return true;
+}
+
+static void uring_submit_or_kill(pid_t pid, struct pink_uring *ring,
+				 unsigned wait_nr)
+{
+	int r;
+
+	if ((r = pink_uring_submit(ring, wait_nr)) < 0) {
+		kill(pid, SIGKILL);
+		fail_verbose("pink_uring_submit (wait_nr:%u errno:%d %s)",
+			     wait_nr, -r, strerror(-r));
+	}
+}
+
+/*
+ * Reap a single wait completion, returns false if the kernel does not
+ * support waiting for processes using io_uring.
+ */
+static bool uring_reap_wait_or_kill(pid_t pid, struct pink_uring *ring,
+				    int *status)
+{
+	struct pink_uring_event event;
+
+	uring_submit_or_kill(pid, ring, 1);
+	if (pink_uring_reap(ring, &event, 1) != 1) {
+		kill(pid, SIGKILL);
+		fail_verbose("pink_uring_reap returned no completion");
+	}
+	info("\turing wait = %d (pid:%d status:%#x)\n",
+	     event.res, event.pid, (unsigned)event.status);
+	if (event.op == PINK_URING_OP_WAIT && event.res == -EINVAL) {
+		message("\tIORING_OP_WAITID not supported, skipping test\n");
+		kill(pid, SIGKILL);
+		waitpid_no_intr(pid, NULL, __WALL);
+		return false;
+	}
+	if (event.op != PINK_URING_OP_WAIT || event.res < 0 || event.pid != pid) {
+		kill(pid, SIGKILL);
+		fail_verbose("unexpected completion (op:%d res:%d pid:%d), expected wait for pid:%u",
+			     event.op, event.res, event.pid, pid);
+	}
+	*status = event.status;
+	return true;
+}
+
+/*
+ * Test whether stops are harvested correctly using io_uring:
+ * First fork a new child and wait for the initial SIGSTOP, then resume it
+ * with PTRACE_SYSCALL and check whether the system call stop has the SYSGOOD
+ * bit set. Kill the child and check the termination is reported correctly.
+ */
+static void test_uring_wait(void)
+{
+	int r, status;
+	pid_t pid;
+	struct pink_uring *ring;
+
+	if (!uring_alloc_or_skip(&ring, 4))
+		return;
+
+	pid = fork_assert();
+	if (pid == 0) {
+		trace_me_and_stop();
+		syscall(PINK_SYSCALL_INVALID, 0, 0, 0, 0, 0, 0);
+		_exit(0);
+	}
+
+	if ((r = pink_uring_wait_pid(ring, pid, 0, NULL)) < 0) {
+		kill(pid, SIGKILL);
+		fail_verbose("pink_uring_wait_pid (pid:%u errno:%d %s)",
+			     pid, -r, strerror(-r));
+	}
+	if (!uring_reap_wait_or_kill(pid, ring, &status))
+		goto out;
+	check_stopped_or_kill(pid, status);
+	if (WSTOPSIG(status) != SIGSTOP) {
+		kill(pid, SIGKILL);
+		fail_verbose("unexpected stop signal %d, expected SIGSTOP", WSTOPSIG(status));
+	}
+	trace_setup_or_kill(pid, test_options);
+	trace_syscall_or_kill(pid, 0);
+
+	pink_uring_wait_pid(ring, pid, 0, NULL);
+	uring_reap_wait_or_kill(pid, ring, &status);
+	check_stopped_or_kill(pid, status);
+	if (WSTOPSIG(status) != (SIGTRAP|0x80) ||
+	    event_decide_and_print(status) != PINK_EVENT_NONE) {
+		kill(pid, SIGKILL);
+		fail_verbose("unexpected stop status %#x, expected syscall stop",
+			     (unsigned)status);
+	}
+
+	kill(pid, SIGKILL);
+	pink_uring_wait_pid(ring, pid, 0, NULL);
+	uring_reap_wait_or_kill(pid, ring, &status);
+	check_signal_or_fail(status, SIGKILL);
+out:
+	pink_uring_free(ring);
+}
+
+/*
+ * Test whether stops and writes are batched in a single submission:
+ * First fork a few children, queue a wait for each of them together with a
+ * write to a pipe, submit them at once and check every child's initial
+ * SIGSTOP and the write are reported.
+ */
+static void test_uring_batch(void)
+{
+	int r, pfd[2];
+	unsigned i, n, nr_stops, nr_writes;
+	pid_t pid[URING_CHILDREN];
+	char buf[sizeof("pink floyd")];
+	const char *msg = "pink floyd";
+	struct pink_uring *ring;
+	struct pink_uring_event events[URING_CHILDREN + 1];
+
+	if (!uring_alloc_or_skip(&ring, URING_CHILDREN + 1))
+		return;
+	if (pipe(pfd) < 0)
+		fail_verbose("pipe (errno:%d %s)", errno, strerror(errno));
+
+	for (i = 0; i < URING_CHILDREN; i++) {
+		pid[i] = fork_assert();
+		if (pid[i] == 0) {
+			trace_me_and_stop();
+			_exit(0);
+		}
+		pink_uring_wait_pid(ring, pid[i], 0, &pid[i]);
+	}
+	if ((r = pink_uring_write(ring, pfd[1], msg, strlen(msg) + 1, NULL)) < 0)
+		fail_verbose("pink_uring_write (errno:%d %s)", -r, strerror(-r));
+
+	nr_stops = nr_writes = 0;
+	while (nr_stops + nr_writes < URING_CHILDREN + 1) {
+		uring_submit_or_kill(pid[0], ring, 1);
+		n = pink_uring_reap(ring, events, URING_CHILDREN + 1);
+		for (i = 0; i < n; i++) {
+			if (events[i].op == PINK_URING_OP_WRITE) {
+				if (events[i].res != (int)strlen(msg) + 1)
+					fail_verbose("pink_uring_write wrote %d bytes, expected %zu",
+						     events[i].res, strlen(msg) + 1);
+				nr_writes++;
+				continue;
+			}
+			if (events[i].res == -EINVAL) {
+				message("\tIORING_OP_WAITID not supported, skipping test\n");
+				goto out;
+			}
+			if (events[i].res < 0 ||
+			    events[i].pid != *(pid_t *)events[i].data)
+				fail_verbose("unexpected completion (res:%d pid:%d), expected pid:%d",
+					     events[i].res, events[i].pid,
+					     *(pid_t *)events[i].data);
+			check_stopped_or_kill(events[i].pid, events[i].status);
+			nr_stops++;
+		}
+	}
+	info("\tbatch: %u stops %u writes\n", nr_stops, nr_writes);
+
+	if (read(pfd[0], buf, sizeof(buf)) != sizeof(buf) || strcmp(buf, msg))
+		fail_verbose("pipe didn't receive the message written using io_uring");
+out:
+	for (i = 0; i < URING_CHILDREN; i++) {
+		kill(pid[i], SIGKILL);
+		waitpid_no_intr(pid[i], NULL, __WALL);
+	}
+	close(pfd[0]);
+	close(pfd[1]);
+	pink_uring_free(ring);
+}
+
+static void test_fixture_uring(void) {
+	test_fixture_start();
+
+	run_test(test_uring_wait);
+	run_test(test_uring_batch);
+
+	test_fixture_end();
+}
+
+void test_suite_uring(void) {
+	test_fixture_uring();
+}
@@ -0,0 +1,347 @@
+/*
+ * Copyright (c) 2021 Ali Polatel <alip@exherbo.org>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include <pinktrace/private.h>
+
+#include <signal.h>
+#include <sys/mman.h>
+#if PINK_HAVE_IO_URING
+#include <linux/io_uring.h>
+#endif
+
+#include <pinktrace/pink.h>
+
+#if PINK_HAVE_IO_URING
+
+#if !HAVE_DECL_IORING_OP_WAITID
+# define IORING_OP_WAITID 50
+#endif
+
+#ifndef P_PIDFD
+# define P_PIDFD 3
+#endif
+
+/*
+ * Operations are tracked in slots which hold the user data and, for waits,
+ * the siginfo structure the kernel fills in on completion. The index of the
+ * slot is passed as the user data of the submission queue entry.
+ */
+struct pink_uring_slot {
+	enum pink_uring_op op;
+	void *data;
+	siginfo_t info;
+};
+
+struct pink_uring {
+	int fd;
+
+	void *sq_ring;
+	size_t sq_ring_size;
+	unsigned *sq_head;
+	unsigned *sq_tail;
+	unsigned *sq_mask;
+	unsigned *sq_array;
+	unsigned sq_entries;
+	unsigned sq_local_tail;
+	struct io_uring_sqe *sqes;
+	size_t sqes_size;
+
+	void *cq_ring;
+	size_t cq_ring_size;
+	unsigned *cq_head;
+	unsigned *cq_tail;
+	unsigned *cq_mask;
+	struct io_uring_cqe *cqes;
+
+	struct pink_uring_slot *slots;
+	unsigned *free_slots;
+	unsigned nr_free_slots;
+};
+
+static void uring_unmap(struct pink_uring *ring)
+{
+	if (ring->sqes)
+		munmap(ring->sqes, ring->sqes_size);
+	if (ring->cq_ring && ring->cq_ring != ring->sq_ring)
+		munmap(ring->cq_ring, ring->cq_ring_size);
+	if (ring->sq_ring)
+		munmap(ring->sq_ring, ring->sq_ring_size);
+}
+
+static int uring_map(struct pink_uring *ring, const struct io_uring_params *p)
+{
+	char *sq, *cq;
+
+	ring->sq_ring_size = p->sq_off.array + p->sq_entries * sizeof(unsigned);
+	ring->cq_ring_size = p->cq_off.cqes + p->cq_entries * sizeof(struct io_uring_cqe);
+	if (p->features & IORING_FEAT_SINGLE_MMAP) {
+		ring->sq_ring_size = MAX(ring->sq_ring_size, ring->cq_ring_size);
+		ring->cq_ring_size = ring->sq_ring_size;
+	}
+
+	ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ|PROT_WRITE,
+			     MAP_SHARED|MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+	if (ring->sq_ring == MAP_FAILED) {
+		ring->sq_ring = NULL;
+		return -errno;
+	}
+	if (p->features & IORING_FEAT_SINGLE_MMAP) {
+		ring->cq_ring = ring->sq_ring;
+	} else {
+		ring->cq_ring = mmap(NULL, ring->cq_ring_size, PROT_READ|PROT_WRITE,
+				     MAP_SHARED|MAP_POPULATE, ring->fd,
+				     IORING_OFF_CQ_RING);
+		if (ring->cq_ring == MAP_FAILED) {
+			ring->cq_ring = NULL;
+			return -errno;
+		}
+	}
+	ring->sqes_size = p->sq_entries * sizeof(struct io_uring_sqe);
+	ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ|PROT_WRITE,
+			  MAP_SHARED|MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+	if (ring->sqes == MAP_FAILED) {
+		ring->sqes = NULL;
+		return -errno;
+	}
+
+	sq = ring->sq_ring;
+	ring->sq_head = (unsigned *)(sq + p->sq_off.head);
+	ring->sq_tail = (unsigned *)(sq + p->sq_off.tail);
+	ring->sq_mask = (unsigned *)(sq + p->sq_off.ring_mask);
+	ring->sq_array = (unsigned *)(sq + p->sq_off.array);
+	ring->sq_entries = p->sq_entries;
+	ring->sq_local_tail = *ring->sq_tail;
+
+	cq = ring->cq_ring;
+	ring->cq_head = (unsigned *)(cq + p->cq_off.head);
+	ring->cq_tail = (unsigned *)(cq + p->cq_off.tail);
+	ring->cq_mask = (unsigned *)(cq + p->cq_off.ring_mask);
+	ring->cqes = (struct io_uring_cqe *)(cq + p->cq_off.cqes);
+
+	return 0;
+}
+
+/*
+ * Grab a submission queue entry and a slot for a new operation.
+ * The completion queue is twice as large as the submission queue by default,
+ * limiting the number of operations in flight to the number of completion
+ * queue entries makes sure completions are never dropped.
+ */
+static int uring_get_sqe(struct pink_uring *ring, enum pink_uring_op op,
+			 void *data, struct io_uring_sqe **sqeptr,
+			 struct pink_uring_slot **slotptr)
+{
+	unsigned head, idx, slot;
+	struct io_uring_sqe *sqe;
+
+	head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+	if (ring->sq_local_tail - head >= ring->sq_entries)
+		return -EAGAIN;
+	if (ring->nr_free_slots == 0)
+		return -EBUSY;
+
+	slot = ring->free_slots[--ring->nr_free_slots];
+	ring->slots[slot].op = op;
+	ring->slots[slot].data = data;
+
+	idx = ring->sq_local_tail & *ring->sq_mask;
+	sqe = &ring->sqes[idx];
+	memset(sqe, 0, sizeof(struct io_uring_sqe));
+	sqe->user_data = slot;
+	ring->sq_array[idx] = idx;
+	ring->sq_local_tail++;
+
+	*sqeptr = sqe;
+	if (slotptr)
+		*slotptr = &ring->slots[slot];
+	return 0;
+}
+
+static int uring_wait(struct pink_uring *ring, idtype_t idtype, id_t id,
+		      int options, void *data)
+{
+	int r;
+	struct io_uring_sqe *sqe;
+	struct pink_uring_slot *slot;
+
+	if ((r = uring_get_sqe(ring, PINK_URING_OP_WAIT, data, &sqe, &slot)) < 0)
+		return r;
+	memset(&slot->info, 0, sizeof(siginfo_t));
+	sqe->opcode = IORING_OP_WAITID;
+	sqe->fd = id;
+	sqe->len = idtype;
+	sqe->file_index = options | WEXITED | WSTOPPED | __WALL;
+	sqe->addr2 = (uintptr_t)&slot->info;
+	return 0;
+}
+#endif /* PINK_HAVE_IO_URING */
+
+PINK_GCC_ATTR((nonnull(1)))
+int pink_uring_alloc(struct pink_uring **ringptr, unsigned entries)
+{
+#if PINK_HAVE_IO_URING
+	int r;
+	unsigned i;
+	struct io_uring_params p;
+	struct pink_uring *ring;
+
+	ring = calloc(1, sizeof(struct pink_uring));
+	if (!ring)
+		return -errno;
+
+	memset(&p, 0, sizeof(struct io_uring_params));
+	ring->fd = syscall(__NR_io_uring_setup, entries, &p);
+	if (ring->fd < 0) {
+		r = -errno;
+		free(ring);
+		return r;
+	}
+	if ((r = uring_map(ring, &p)) < 0)
+		goto fail;
+
+	ring->slots = calloc(p.cq_entries, sizeof(struct pink_uring_slot));
+	ring->free_slots = calloc(p.cq_entries, sizeof(unsigned));
+	if (!ring->slots || !ring->free_slots) {
+		r = -errno;
+		goto fail;
+	}
+	for (i = 0; i < p.cq_entries; i++)
+		ring->free_slots[i] = p.cq_entries - i - 1;
+	ring->nr_free_slots = p.cq_entries;
+
+	*ringptr = ring;
+	return 0;
+fail:
+	pink_uring_free(ring);
+	return r;
+#else
+	return -ENOSYS;
+#endif
+}
+
+void pink_uring_free(struct pink_uring *ring)
+{
+#if PINK_HAVE_IO_URING
+	if (!ring)
+		return;
+	uring_unmap(ring);
+	close(ring->fd);
+	free(ring->slots);
+	free(ring->free_slots);
+	free(ring);
+#endif
+}
+
+PINK_GCC_ATTR((nonnull(1)))
+int pink_uring_fd(const struct pink_uring *ring)
+{
+#if PINK_HAVE_IO_URING
+	return ring->fd;
+#else
+	return -ENOSYS;
+#endif
+}
+
+PINK_GCC_ATTR((nonnull(1)))
+int pink_uring_wait_pid(struct pink_uring *ring, pid_t pid, int options,
+			void *data)
+{
+#if PINK_HAVE_IO_URING
+	if (pid == -1)
+		return uring_wait(ring, P_ALL, 0, options, data);
+	return uring_wait(ring, P_PID, pid, options, data);
+#else
+	return -ENOSYS;
+#endif
+}
+
+PINK_GCC_ATTR((nonnull(1)))
+int pink_uring_wait_pidfd(struct pink_uring *ring, int pidfd, int options,
+			  void *data)
+{
+#if PINK_HAVE_IO_URING
+	return uring_wait(ring, P_PIDFD, pidfd, options, data);
+#else
+	return -ENOSYS;
+#endif
+}
+
+PINK_GCC_ATTR((nonnull(1,3)))
+int pink_uring_write(struct pink_uring *ring, int fd, const void *buf,
+		     size_t len, void *data)
+{
+#if PINK_HAVE_IO_URING
+	int r;
+	struct io_uring_sqe *sqe;
+
+	if ((r = uring_get_sqe(ring, PINK_URING_OP_WRITE, data, &sqe, NULL)) < 0)
+		return r;
+	sqe->opcode = IORING_OP_WRITE;
+	sqe->fd = fd;
+	sqe->addr = (uintptr_t)buf;
+	sqe->len = len;
+	sqe->off = (uint64_t)-1; /* use and update the file position */
+	return 0;
+#else
+	return -ENOSYS;
+#endif
+}
+
+PINK_GCC_ATTR((nonnull(1)))
+int pink_uring_submit(struct pink_uring *ring, unsigned wait_nr)
+{
+#if PINK_HAVE_IO_URING
+	int r;
+	unsigned to_submit;
+
+	to_submit = ring->sq_local_tail - *ring->sq_tail;
+	__atomic_store_n(ring->sq_tail, ring->sq_local_tail, __ATOMIC_RELEASE);
+
+	r = syscall(__NR_io_uring_enter, ring->fd, to_submit, wait_nr,
+		    wait_nr ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+	return r < 0 ? -errno : r;
+#else
+	return -ENOSYS;
+#endif
+}
+
+PINK_GCC_ATTR((nonnull(1,2)))
+int pink_uring_reap(struct pink_uring *ring, struct pink_uring_event *events,
+		    unsigned count)
+{
+#if PINK_HAVE_IO_URING
+	unsigned head, tail, n = 0;
+
+	head = *ring->cq_head;
+	tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+	for (; head != tail && n < count; head++, n++) {
+		struct io_uring_cqe *cqe;
+		struct pink_uring_slot *slot;
+		struct pink_uring_event *event = &events[n];
+
+		cqe = &ring->cqes[head & *ring->cq_mask];
+		slot = &ring->slots[cqe->user_data];
+
+		event->op = slot->op;
+		event->data = slot->data;
+		event->res = cqe->res;
+		event->pid = 0;
+		event->status = 0;
+		if (slot->op == PINK_URING_OP_WAIT && cqe->res >= 0 &&
+		    slot->info.si_pid != 0) {
+			if (siginfo_to_status(&slot->info, &event->status) < 0)
+				event->res = -EINVAL;
+			else
+				event->pid = slot->info.si_pid;
+		}
+
+		ring->free_slots[ring->nr_free_slots++] = cqe->user_data;
+	}
+	__atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+	return n;
+#else
+	return -ENOSYS;
+#endif
+}
@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2021 Ali Polatel <alip@exherbo.org>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#ifndef PINK_URING_H
+#define PINK_URING_H
+
+/**
+ * @file pinktrace/uring.h
+ * @brief Pink's io_uring backend for event loops
+ *
+ * Do not include this file directly. Use pinktrace/pink.h instead.
+ *
+ * These functions let a tracer queue waits for tracee state changes together
+ * with its own I/O, eg writing trace logs, on an @e io_uring(7) instance and
+ * submit them all with a single system call:
+ *
+ * - pink_uring_wait_pid() and pink_uring_wait_pidfd() queue a @e waitid(2)
+ *   operation which completes when the tracee changes state.
+ * - pink_uring_write() queues a write to a file descriptor.
+ * - pink_uring_submit() submits the queued operations and optionally waits
+ *   for completions.
+ * - pink_uring_reap() harvests the completions without entering the kernel.
+ *
+ * Waiting for processes requires Linux-6.7 or newer. On older kernels the
+ * waits complete with @c -EINVAL which the caller may use to fall back to
+ * pink_pidfd_wait() or @e waitpid(2).
+ *
+ * @see PINK_HAVE_IO_URING
+ *
+ * @defgroup pink_uring Pink's io_uring backend for event loops
+ * @ingroup pinktrace
+ * @{
+ **/
+
+#include <stddef.h>
+#include <sys/types.h>
+
+/** Opaque structure which represents an io_uring instance */
+struct pink_uring;
+
+/** Operation of a completion */
+enum pink_uring_op {
+	/** Wait queued by pink_uring_wait_pid() or pink_uring_wait_pidfd() */
+	PINK_URING_OP_WAIT = 0,
+	/** Write queued by pink_uring_write() */
+	PINK_URING_OP_WRITE,
+};
+
+/** Structure which represents a completion */
+struct pink_uring_event {
+	/** Operation, see enum pink_uring_op */
+	enum pink_uring_op op;
+	/** User data given when the operation was queued */
+	void *data;
+	/**
+	 * Result of the operation, negated errno on failure.
+	 * For writes, this is the number of bytes written.
+	 **/
+	int res;
+	/**
+	 * For waits, process ID of the tracee which changed state, 0 if
+	 * @c WNOHANG was specified and there was no state change
+	 **/
+	pid_t pid;
+	/**
+	 * For waits, status which may be inspected using the @e wait(2)
+	 * macros and pink_event_decide()
+	 **/
+	int status;
+};
+
+/**
+ * Allocate an io_uring instance
+ *
+ * @see PINK_HAVE_IO_URING
+ *
+ * @param ringptr Pointer to store the dynamically allocated instance,
+ *                must @b not be @e NULL
+ * @param entries Number of operations which may be queued before a submit
+ * @return 0 on success, negated errno on failure
+ **/
+int pink_uring_alloc(struct pink_uring **ringptr, unsigned entries)
+	PINK_GCC_ATTR((nonnull(1)));
+
+/**
+ * Free the io_uring instance
+ *
+ * @note Operations which haven't completed yet are cancelled.
+ *
+ * @param ring io_uring instance
+ **/
+void pink_uring_free(struct pink_uring *ring);
+
+/**
+ * Return the file descriptor of the io_uring instance
+ *
+ * @note The file descriptor becomes readable when there are completions
+ *       to reap so it may be added to an @e epoll(7) set.
+ *
+ * @param ring io_uring instance
+ * @return File descriptor
+ **/
+int pink_uring_fd(const struct pink_uring *ring)
+	PINK_GCC_ATTR((nonnull(1)));
+
+/**
+ * Queue a wait for a state change of the given process
+ *
+ * @note @c WEXITED, @c WSTOPPED and @c __WALL are always added to options.
+ *
+ * @param ring io_uring instance
+ * @param pid Process ID, -1 to wait for any child
+ * @param options Additional options to @e waitid(2), eg @c WNOHANG
+ * @param data User data returned with the completion
+ * @return 0 on success, @c -EAGAIN if the submission queue is full,
+ *         @c -EBUSY if too many operations are in flight
+ **/
+int pink_uring_wait_pid(struct pink_uring *ring, pid_t pid, int options,
+			void *data)
+	PINK_GCC_ATTR((nonnull(1)));
+
+/**
+ * Queue a wait for a state change of the process referred to by the file
+ * descriptor
+ *
+ * @note @c WEXITED, @c WSTOPPED and @c __WALL are always added to options.
+ *
+ * @param ring io_uring instance
+ * @param pidfd PID file descriptor, see pink_pidfd_open()
+ * @param options Additional options to @e waitid(2), eg @c WNOHANG
+ * @param data User data returned with the completion
+ * @return 0 on success, @c -EAGAIN if the submission queue is full,
+ *         @c -EBUSY if too many operations are in flight
+ **/
+int pink_uring_wait_pidfd(struct pink_uring *ring, int pidfd, int options,
+			  void *data)
+	PINK_GCC_ATTR((nonnull(1)));
+
+/**
+ * Queue a write to the given file descriptor
+ *
+ * @note The buffer must stay valid until the write completes.
+ *
+ * @param ring io_uring instance
+ * @param fd File descriptor
+ * @param buf Buffer
+ * @param len Number of bytes to write
+ * @param data User data returned with the completion
+ * @return 0 on success, @c -EAGAIN if the submission queue is full,
+ *         @c -EBUSY if too many operations are in flight
+ **/
+int pink_uring_write(struct pink_uring *ring, int fd, const void *buf,
+		     size_t len, void *data)
+	PINK_GCC_ATTR((nonnull(1,3)));
+
+/**
+ * Submit the queued operations
+ *
+ * @param ring io_uring instance
+ * @param wait_nr Number of completions to wait for, 0 to return immediately
+ * @return Number of operations submitted on success, negated errno on failure
+ **/
+int pink_uring_submit(struct pink_uring *ring, unsigned wait_nr)
+	PINK_GCC_ATTR((nonnull(1)));
+
+/**
+ * Harvest the completions
+ *
+ * @note This function does not enter the kernel.
+ *
+ * @param ring io_uring instance
+ * @param events Array to store the completions
+ * @param count Number of elements of the array
+ * @return Number of completions stored
+ **/
+int pink_uring_reap(struct pink_uring *ring, struct pink_uring_event *events,
+		    unsigned count)
+	PINK_GCC_ATTR((nonnull(1,2)));
+
+/** @} */
+#endif
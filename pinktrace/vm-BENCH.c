@@ -0,0 +1,330 @@
+/*
+ * Copyright (c) 2021 Ali Polatel <alip@exherbo.org>
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "pinktrace-bench.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#define BENCH_MAX_SIZE		(1024 * 1024)
+/* Bytes transferred per size with cross memory attach and with ptrace */
+#define BENCH_CBUDGET		(64 * 1024 * 1024)
+#define BENCH_LBUDGET		(4 * 1024 * 1024)
+/* Number of members of the string arrays */
+#define BENCH_ARRAY_LEN		16
+
+static const size_t bench_sizes[] = {
+	8, 64, 512, 4096, 65536, BENCH_MAX_SIZE,
+};
+
+enum bench_variant {
+	BENCH_ALIGNED,
+	BENCH_UNALIGNED,
+	BENCH_CROSSPAGE,
+};
+static const char *const bench_variants[] = {
+	"aligned", "unaligned", "crosspage",
+};
+
+enum bench_op {
+	BENCH_CREAD,
+	BENCH_LREAD,
+	BENCH_CREAD_NUL,
+	BENCH_LREAD_NUL,
+	BENCH_CWRITE,
+	BENCH_LWRITE,
+};
+static const struct {
+	const char *name;
+	uint64_t budget;
+	bool nul;
+} bench_ops[] = {
+	[BENCH_CREAD]		= {"vm_cread",		BENCH_CBUDGET,	false},
+	[BENCH_LREAD]		= {"vm_lread",		BENCH_LBUDGET,	false},
+	[BENCH_CREAD_NUL]	= {"vm_cread_nul",	BENCH_CBUDGET,	true},
+	[BENCH_LREAD_NUL]	= {"vm_lread_nul",	BENCH_LBUDGET,	true},
+	[BENCH_CWRITE]		= {"vm_cwrite",		BENCH_CBUDGET,	false},
+	[BENCH_LWRITE]		= {"vm_lwrite",		BENCH_LBUDGET,	false},
+};
+
+/*
+ * The tracee is forked after the area is set up, so the area is at the same
+ * address in both processes and the tracee never runs.
+ */
+static char *area;
+static size_t area_size;
+static size_t page_size;
+static char buf[BENCH_MAX_SIZE];
+
+static bool bench_setup(void)
+{
+	if (area)
+		return true;
+
+	page_size = sysconf(_SC_PAGESIZE);
+	area_size = BENCH_MAX_SIZE + 4 * page_size;
+	area = mmap(NULL, area_size, PROT_READ | PROT_WRITE,
+		    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (area == MAP_FAILED) {
+		area = NULL;
+		fail_verbose("mmap failed (errno:%d %s)", errno, strerror(errno));
+		return false;
+	}
+	memset(area, 'a', area_size);
+	return true;
+}
+
+/* Offset of the data of the given size in the area */
+static size_t bench_offset(enum bench_variant variant, size_t size)
+{
+	switch (variant) {
+	case BENCH_UNALIGNED:
+		return page_size + 3;
+	case BENCH_CROSSPAGE:
+		return 2 * page_size - MIN(size, page_size) / 2;
+	case BENCH_ALIGNED:
+	default:
+		return page_size;
+	}
+}
+
+/* Fork a tracee which stays stopped until it is killed */
+static pid_t bench_tracee(struct pink_regset **regsetptr)
+{
+	int r, status;
+	pid_t pid;
+
+	pid = fork_assert();
+	if (pid == 0) {
+		trace_me_and_stop();
+		_exit(1); /* expect to be killed */
+	}
+	waitpid_no_intr(pid, &status, 0);
+	check_stopped_or_kill(pid, status);
+	/* Not regset_fill_or_kill(), which dumps the registers. */
+	if ((r = pink_regset_alloc(regsetptr)) < 0 ||
+	    (r = pink_regset_fill(pid, *regsetptr)) < 0) {
+		kill(pid, SIGKILL);
+		fail_verbose("regset (errno:%d %s)", -r, strerror(-r));
+	}
+	return pid;
+}
+
+static void bench_kill(pid_t pid, struct pink_regset *regset)
+{
+	int status;
+
+	kill(pid, SIGKILL);
+	waitpid_no_intr(pid, &status, 0);
+	pink_regset_free(regset);
+}
+
+static ssize_t bench_vm_op(enum bench_op op, pid_t pid,
+			   struct pink_regset *regset, long addr, size_t len)
+{
+	switch (op) {
+	case BENCH_CREAD:
+		return pink_vm_cread(pid, regset, addr, buf, len);
+	case BENCH_LREAD:
+		return pink_vm_lread(pid, regset, addr, buf, len);
+	case BENCH_CREAD_NUL:
+		return pink_vm_cread_nul(pid, regset, addr, buf, len);
+	case BENCH_LREAD_NUL:
+		return pink_vm_lread_nul(pid, regset, addr, buf, len);
+	case BENCH_CWRITE:
+		return pink_vm_cwrite(pid, regset, addr, buf, len);
+	case BENCH_LWRITE:
+		return pink_vm_lwrite(pid, regset, addr, buf, len);
+	default:
+		_pink_assert_not_reached();
+	}
+}
+
+/*
+ * Measure the given memory access function with every size and variant.
+ * Strings of the _nul variants end at the last byte so the whole size is
+ * searched; only they have the crosspage variant.
+ * pink_vm_lread_nul() does not count the terminating zero, the others do.
+ */
+static void bench_vm(void)
+{
+	enum bench_op op = _i;
+	enum bench_variant variant;
+	unsigned s;
+
+	if (!bench_setup())
+		return;
+
+	for (variant = BENCH_ALIGNED; variant <= BENCH_CROSSPAGE; variant++) {
+		if (variant == BENCH_CROSSPAGE && !bench_ops[op].nul)
+			continue;
+		for (s = 0; s < ARRAY_SIZE(bench_sizes); s++) {
+			size_t size = bench_sizes[s];
+			size_t off = bench_offset(variant, size);
+			long addr = (long)(area + off);
+			unsigned long i, count;
+			uint64_t start, cpu, t;
+			ssize_t r = 0;
+			int save_errno;
+			pid_t pid;
+			struct pink_regset *regset;
+			struct bench_result result;
+
+			if (bench_ops[op].nul)
+				area[off + size - 1] = '\0';
+			pid = bench_tracee(&regset);
+			if (bench_ops[op].nul)
+				area[off + size - 1] = 'a';
+
+			count = bench_iterations(bench_ops[op].budget, size);
+			memset(&result, 0, sizeof(result));
+			if (!(result.samples = bench_samples(count))) {
+				bench_kill(pid, regset);
+				return;
+			}
+
+			start = bench_now();
+			cpu = bench_cpu_time();
+			for (i = 0; i < count; i++) {
+				t = bench_now();
+				r = bench_vm_op(op, pid, regset, addr, size);
+				result.samples[i] = bench_now() - t;
+				if (r < (ssize_t)size - bench_ops[op].nul)
+					break;
+			}
+			result.elapsed = bench_now() - start;
+			result.cpu = bench_cpu_time() - cpu;
+			save_errno = errno;
+			bench_kill(pid, regset);
+			errno = save_errno;
+
+			if (r < 0 && errno == ENOSYS) {
+				info("\t%s: not supported\n", bench_ops[op].name);
+				free(result.samples);
+				return;
+			}
+			if (i < count) {
+				fail_verbose("%s (addr:%#lx len:%zu) = %zd (errno:%d %s)",
+					     bench_ops[op].name, addr, size, r,
+					     errno, strerror(errno));
+				free(result.samples);
+				return;
+			}
+
+			result.name = bench_ops[op].name;
+			result.variant = bench_variants[variant];
+			result.param = size;
+			result.count = count;
+			result.bytes = (uint64_t)count * size;
+			result.nsamples = count;
+			bench_report(&result);
+			free(result.samples);
+		}
+	}
+}
+
+/*
+ * Measure reading every member of a string array, like the argv of execve,
+ * with members of every size up to 64k.
+ */
+static void bench_read_string_array(void)
+{
+	unsigned s;
+
+	if (!bench_setup())
+		return;
+
+	for (s = 0; s < ARRAY_SIZE(bench_sizes); s++) {
+		size_t size = bench_sizes[s];
+		char **array = (char **)area;
+		char *strings = area + page_size;
+		unsigned long i, count;
+		uint64_t start, cpu, t;
+		ssize_t r = 0;
+		int save_errno;
+		unsigned j;
+		bool nullp;
+		pid_t pid;
+		struct pink_regset *regset;
+		struct bench_result result;
+
+		if (size * BENCH_ARRAY_LEN > area_size - page_size)
+			break;
+		for (j = 0; j < BENCH_ARRAY_LEN; j++) {
+			array[j] = strings + j * size;
+			array[j][size - 1] = '\0';
+		}
+		array[BENCH_ARRAY_LEN] = NULL;
+		pid = bench_tracee(&regset);
+		memset(area, 'a', area_size);
+
+		count = bench_iterations(BENCH_CBUDGET,
+					 size * BENCH_ARRAY_LEN);
+		memset(&result, 0, sizeof(result));
+		if (!(result.samples = bench_samples(count))) {
+			bench_kill(pid, regset);
+			return;
+		}
+
+		start = bench_now();
+		cpu = bench_cpu_time();
+		for (i = 0; i < count; i++) {
+			t = bench_now();
+			for (j = 0; j < BENCH_ARRAY_LEN; j++) {
+				r = pink_read_string_array(pid, regset,
+							   (long)array, j,
+							   buf, size, &nullp);
+				if (r != (ssize_t)size || nullp)
+					break;
+			}
+			result.samples[i] = bench_now() - t;
+			if (j < BENCH_ARRAY_LEN)
+				break;
+		}
+		result.elapsed = bench_now() - start;
+		result.cpu = bench_cpu_time() - cpu;
+		save_errno = errno;
+		bench_kill(pid, regset);
+		errno = save_errno;
+
+		if (i < count) {
+			fail_verbose("pink_read_string_array (index:%u len:%zu) = %zd (errno:%d %s)",
+				     j, size, r, errno, strerror(errno));
+			free(result.samples);
+			return;
+		}
+
+		result.name = "read_string_array";
+		result.variant = bench_variants[BENCH_ALIGNED];
+		result.param = size;
+		result.count = count;
+		result.bytes = (uint64_t)count * size * BENCH_ARRAY_LEN;
+		result.nsamples = count;
+		bench_report(&result);
+		free(result.samples);
+	}
+}
+
+static void bench_fixture_vm(void)
+{
+	test_fixture_start();
+
+	for (_i = BENCH_CREAD; _i <= BENCH_LWRITE; _i++)
+		run_test(bench_vm);
+	run_test(bench_read_string_array);
+
+	test_fixture_end();
+}
+
+void bench_suite_vm(void)
+{
+	bench_fixture_vm();
+}
@@ -179,6 +179,49 @@ ssize_t pink_vm_cread(pid_t pid, const struct pink_regset *regset,
 	return process_vm_readv(pid, local, 1, remote, 1, /*flags:*/0);
 }
 
+#ifndef IOV_MAX
+# define IOV_MAX 1024
+#endif
+
+PINK_GCC_ATTR((nonnull(2,3,4)))
+ssize_t pink_vm_creadv(pid_t pid, const struct pink_regset *regset,
+		       const struct iovec *local, const struct iovec *remote,
+		       size_t count)
+{
+	ssize_t count_read = 0;
+
+	while (count > 0) {
+		ssize_t r;
+		size_t i, n, len = 0;
+
+		n = MIN(count, IOV_MAX);
+		for (i = 0; i < n; i++)
+			len += local[i].iov_len;
+
+		r = process_vm_readv(pid, local, n, remote, n, /*flags:*/ 0);
+		if (r < 0)
+			return count_read > 0 ? count_read : -1;
+		count_read += r;
+		if ((size_t)r != len)
+			break; /* partial read */
+
+		local += n;
+		remote += n;
+		count -= n;
+	}
+	return count_read;
+}
+
+ssize_t vm_cgather(pid_t pid, char *dest, size_t len,
+		   const struct iovec *remote, size_t count)
+{
+	struct iovec local[1];
+
+	local[0].iov_base = dest;
+	local[0].iov_len = len;
+	return process_vm_readv(pid, local, 1, remote, count, /*flags:*/ 0);
+}
+
 PINK_GCC_ATTR((nonnull(2,4)))
 ssize_t pink_vm_cread_nul(pid_t pid, const struct pink_regset *regset,
 			  long addr, char *dest, size_t len)
@@ -25,6 +25,9 @@
  * @{
  **/
 
+#include <sys/types.h>
+#include <sys/uio.h>
+
 /**
  * Read len bytes of data of pid, regset, at address @b addr, to our address
  * space @b dest (ptrace way, one long at a time)
@@ -98,6 +101,32 @@ ssize_t pink_vm_cread(pid_t pid, const struct pink_regset *regset,
 #define pink_vm_cread_object(pid, regset, addr, objp) \
 		pink_vm_cread((pid), (regset), (addr), (char *)(objp), sizeof(*(objp)))
 
+/**
+ * Read the given remote buffers of pid to the given local buffers using
+ * cross memory attach, issuing a single @e process_vm_readv(2) call per
+ * @c IOV_MAX buffers
+ *
+ * @note Remote addresses are used as is, they are not truncated to the word
+ *       size of the ABI of the tracee.
+ * @attention If #PINK_HAVE_PROCESS_VM_READV is defined to 0, this function
+ *            always returns -1 and sets errno to ENOSYS.
+ *
+ * @see PINK_HAVE_PROCESS_VM_READV
+ *
+ * @param pid Process ID
+ * @param regset Registry set
+ * @param local Local buffers
+ * @param remote Remote buffers, the lengths must match the local buffers
+ * @param count Number of buffers
+ * @return On success, this function returns the number of bytes read.
+ *         On error, -1 is returned and errno is set appropriately.
+ *         Check the return value for partial reads.
+ **/
+ssize_t pink_vm_creadv(pid_t pid, const struct pink_regset *regset,
+		       const struct iovec *local, const struct iovec *remote,
+		       size_t count)
+	PINK_GCC_ATTR((nonnull(2,3,4)));
+
 /**
  * Like pink_vm_cread() but make the additional effort of looking for a
  * terminating zero-byte